@@ -0,0 +1,417 @@
+/*
+* Andersen.cpp
+*/
+#include "Andersen.h"
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+
+//===-----------------------------------------------------------------===//
+//////////////////////////  AndersenSolver Class  /////////////////////////
+//===-----------------------------------------------------------------===//
+
+AndersenSolver::AndersenSolver(Graph& graph) : graph(graph)
+{
+}
+
+void
+AndersenSolver::addConstraint(ConstraintKind kind, std::string_view dst,
+                              std::string_view src)
+{
+    // the ids the labels were created with, so that an object keeps its
+    // own name even after its variable is collapsed into another node
+    graph.internLabel(dst);
+    graph.internLabel(src);
+    LabelIndex* labels = graph.getLabelIndex();
+    addConstraint(kind, labels->lookup(dst), labels->lookup(src));
+}
+
+void
+AndersenSolver::addConstraint(ConstraintKind kind, NodeId dst, NodeId src)
+{
+    Constraint constraint = { kind, dst, src };
+    pending.push_back(constraint);
+    stats.constraints++;
+}
+
+// per-node state follows the graph's id space
+void
+AndersenSolver::grow()
+{
+    std::size_t n = graph.numNodeIds();
+    if (pts.size() < n)
+    {
+        pts.resize(n);
+        delta.resize(n);
+        loads.resize(n);
+        stores.resize(n);
+        queued.resize(n, 0);
+        visitIndex.resize(n, INVALID_NODE);
+        visitLow.resize(n);
+        visitDone.resize(n, 0);
+    }
+}
+
+void
+AndersenSolver::push(NodeId n)
+{
+    if (!queued[n])
+    {
+        queued[n] = 1;
+        worklist.push_back(n);
+    }
+}
+
+// adds the pointees in `from` (sorted) that `to` lacks to both its set
+// and its delta; returns true if anything was new
+bool
+AndersenSolver::propagate(const std::vector<NodeId>& from, NodeId to)
+{
+    std::vector<NodeId> added;
+    std::set_difference(from.begin(), from.end(),
+                        pts[to].begin(), pts[to].end(),
+                        std::back_inserter(added));
+    if (added.empty())
+    {
+        return false;
+    }
+
+    std::vector<NodeId> merged;
+    merged.reserve(pts[to].size() + added.size());
+    std::merge(pts[to].begin(), pts[to].end(), added.begin(), added.end(),
+               std::back_inserter(merged));
+    pts[to].swap(merged);
+
+    merged.clear();
+    std::set_union(delta[to].begin(), delta[to].end(),
+                   added.begin(), added.end(), std::back_inserter(merged));
+    delta[to].swap(merged);
+
+    stats.propagations += added.size();
+    push(to);
+    return true;
+}
+
+// maps ids to their live nodes and drops duplicates and dead ids
+void
+AndersenSolver::canonicalize(std::vector<NodeId>& ids)
+{
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < ids.size(); i++)
+    {
+        NodeId id = graph.resolve(ids[i]);
+        if (id != INVALID_NODE)
+        {
+            ids[kept++] = id;
+        }
+    }
+    ids.resize(kept);
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+}
+
+// adds the copy edge from -> to if it is new and pushes everything
+// `from` already points to across it
+bool
+AndersenSolver::addCopyEdge(NodeId from, NodeId to)
+{
+    if (from == to || from == INVALID_NODE || to == INVALID_NODE)
+    {
+        return false;
+    }
+    Node* source = graph.getNodeById(from);
+    Node* target = graph.getNodeById(to);
+    if (source->alreadyHasEdge(target))
+    {
+        return false;
+    }
+    graph.createEdge(source, target);
+    stats.edgesAdded++;
+    propagate(pts[from], to);
+    return true;
+}
+
+void
+AndersenSolver::solve()
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    grow();
+
+    // edges and complex constraints first, so that cycles in the initial
+    // copy graph are collapsed before any pointee travels around them
+    std::size_t i;
+    for (i = 0; i < pending.size(); i++)
+    {
+        NodeId dst = graph.resolve(pending[i].dst);
+        NodeId src = graph.resolve(pending[i].src);
+        if (dst == INVALID_NODE || src == INVALID_NODE)
+        {
+            continue;
+        }
+        switch (pending[i].kind)
+        {
+            case ADDRESS_OF:
+                break;
+            case COPY:
+                addCopyEdge(src, dst);
+                break;
+            case LOAD:
+                loads[src].push_back(dst);
+                if (!pts[src].empty())
+                {
+                    // a solved node gets a new load: replay its whole set
+                    delta[src] = pts[src];
+                    push(src);
+                }
+                break;
+            case STORE:
+                stores[dst].push_back(src);
+                if (!pts[dst].empty())
+                {
+                    delta[dst] = pts[dst];
+                    push(dst);
+                }
+                break;
+        }
+    }
+
+    std::vector<NodeId> roots;
+    for (i = 0; i < pts.size(); i++)
+    {
+        if (graph.getNodeById((NodeId) i) != NULL)
+        {
+            roots.push_back((NodeId) i);
+        }
+    }
+    collapseCycles(roots);
+
+    for (i = 0; i < pending.size(); i++)
+    {
+        if (pending[i].kind != ADDRESS_OF)
+        {
+            continue;
+        }
+        NodeId dst = graph.resolve(pending[i].dst);
+        NodeId src = pending[i].src;
+        if (dst != INVALID_NODE && graph.resolve(src) != INVALID_NODE)
+        {
+            std::vector<NodeId> single(1, src);
+            propagate(single, dst);
+        }
+    }
+    pending.clear();
+
+    std::vector<NodeId> changed;
+    std::vector<NodeId> pointees;
+    std::vector<NodeId> targets;
+    while (!worklist.empty())
+    {
+        NodeId n = worklist.front();
+        worklist.pop_front();
+        queued[n] = 0;
+        n = graph.resolve(n);
+        if (n == INVALID_NODE || delta[n].empty())
+        {
+            continue;
+        }
+        stats.iterations++;
+        changed.clear();
+        changed.swap(delta[n]);
+
+        // loads and stores through n gain edges for each new pointee.
+        // Merged pointees and operands are folded first, or a collapsed
+        // cycle would be visited once per original member
+        if (!loads[n].empty() || !stores[n].empty())
+        {
+            pointees = changed;
+            canonicalize(pointees);
+            canonicalize(loads[n]);
+            canonicalize(stores[n]);
+        }
+        for (i = 0; i < pointees.size(); i++)
+        {
+            std::size_t k;
+            for (k = 0; k < loads[n].size(); k++)
+            {
+                addCopyEdge(pointees[i], loads[n][k]);
+            }
+            for (k = 0; k < stores[n].size(); k++)
+            {
+                addCopyEdge(stores[n][k], pointees[i]);
+            }
+        }
+        pointees.clear();
+
+        // copy edges; targets are copied out since a collapse rewires them
+        targets.clear();
+        std::vector<Edge*>* outEdges = graph.getNodeById(n)->getOutEdges();
+        for (i = 0; i < outEdges->size(); i++)
+        {
+            targets.push_back((*outEdges)[i]->getTarget()->getId());
+        }
+        for (i = 0; i < targets.size(); i++)
+        {
+            NodeId z = graph.resolve(targets[i]);
+            if (z == n || z == INVALID_NODE)
+            {
+                continue;
+            }
+            propagate(changed, z);
+            uint64_t key = ((uint64_t) n << 32) | z;
+            if (pts[z] == pts[n] && checked.insert(key).second
+                && collapseCycles(std::vector<NodeId>(1, z))
+                && graph.resolve(n) != n)
+            {
+                // n was merged away; the node it lives in now was
+                // requeued with its whole set
+                break;
+            }
+        }
+    }
+
+    stats.seconds += std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+//===-----------------------------------------------------------------===//
+// Lazy cycle detection
+
+// iterative Tarjan over the live graph from each of the roots; every
+// strongly connected component of more than one node it finds is
+// collapsed. Returns true if anything was
+bool
+AndersenSolver::collapseCycles(const std::vector<NodeId>& roots)
+{
+    std::vector<NodeId> touched;
+    std::vector<NodeId> stack;
+    std::vector<std::pair<NodeId, std::size_t> > frames;
+    std::vector<std::vector<NodeId> > cycles;
+    NodeId counter = 0;
+
+    for (std::size_t r = 0; r < roots.size(); r++)
+    {
+        NodeId start = roots[r];
+        if (visitIndex[start] != INVALID_NODE)
+        {
+            continue;
+        }
+        visitIndex[start] = visitLow[start] = counter++;
+        touched.push_back(start);
+        stack.push_back(start);
+        frames.push_back(std::make_pair(start, (std::size_t) 0));
+
+        while (!frames.empty())
+        {
+            NodeId v = frames.back().first;
+            std::vector<Edge*>* outEdges = graph.getNodeById(v)->getOutEdges();
+            std::size_t& next = frames.back().second;
+
+            if (next < outEdges->size())
+            {
+                NodeId w = (*outEdges)[next++]->getTarget()->getId();
+                if (visitIndex[w] == INVALID_NODE)
+                {
+                    visitIndex[w] = visitLow[w] = counter++;
+                    touched.push_back(w);
+                    stack.push_back(w);
+                    frames.push_back(std::make_pair(w, (std::size_t) 0));
+                }
+                else if (!visitDone[w])
+                {
+                    visitLow[v] = std::min(visitLow[v], visitIndex[w]);
+                }
+                continue;
+            }
+
+            if (visitLow[v] == visitIndex[v])
+            {
+                std::vector<NodeId> members;
+                NodeId w;
+                do
+                {
+                    w = stack.back();
+                    stack.pop_back();
+                    visitDone[w] = 1;
+                    members.push_back(w);
+                } while (w != v);
+                if (members.size() > 1)
+                {
+                    cycles.push_back(members);
+                }
+            }
+            frames.pop_back();
+            if (!frames.empty())
+            {
+                NodeId parent = frames.back().first;
+                visitLow[parent] = std::min(visitLow[parent], visitLow[v]);
+            }
+        }
+    }
+
+    for (std::size_t i = 0; i < touched.size(); i++)
+    {
+        visitIndex[touched[i]] = INVALID_NODE;
+        visitDone[touched[i]] = 0;
+    }
+    for (std::size_t c = 0; c < cycles.size(); c++)
+    {
+        collapse(cycles[c]);
+    }
+    return !cycles.empty();
+}
+
+// merges the members of a cycle into the first one. Everything the
+// merged node points to is pushed again, since the other members'
+// successors are now its successors too
+void
+AndersenSolver::collapse(const std::vector<NodeId>& members)
+{
+    NodeId rep = members[0];
+    Node* repNode = graph.getNodeById(rep);
+    for (std::size_t i = 1; i < members.size(); i++)
+    {
+        NodeId m = members[i];
+        graph.merge(repNode, graph.getNodeById(m));
+
+        std::vector<NodeId> merged;
+        std::set_union(pts[rep].begin(), pts[rep].end(),
+                       pts[m].begin(), pts[m].end(), std::back_inserter(merged));
+        pts[rep].swap(merged);
+        loads[rep].insert(loads[rep].end(), loads[m].begin(), loads[m].end());
+        stores[rep].insert(stores[rep].end(), stores[m].begin(), stores[m].end());
+
+        std::vector<NodeId>().swap(pts[m]);
+        std::vector<NodeId>().swap(delta[m]);
+        std::vector<NodeId>().swap(loads[m]);
+        std::vector<NodeId>().swap(stores[m]);
+        stats.nodesCollapsed++;
+    }
+    delta[rep] = pts[rep];
+    push(rep);
+    stats.cyclesCollapsed++;
+}
+
+//===-----------------------------------------------------------------===//
+// Results
+
+std::vector<NodeId>
+AndersenSolver::pointsTo(NodeId var)
+{
+    NodeId v = graph.resolve(var);
+    if (v == INVALID_NODE || v >= pts.size())
+    {
+        return std::vector<NodeId>();
+    }
+    return pts[v];
+}
+
+std::vector<NodeId>
+AndersenSolver::pointsTo(std::string_view label)
+{
+    NodeId var = graph.getIdAtLabel(label);
+    if (var == INVALID_NODE)
+    {
+        return std::vector<NodeId>();
+    }
+    return pointsTo(var);
+}
@@ -0,0 +1,110 @@
+/*
+* Andersen.h
+*/
+#ifndef ANDERSEN_H_
+#define ANDERSEN_H_
+
+#include <deque>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+#include "Graph.h"
+
+/////////////////    AndersenSolver Class   //////////////////////
+
+// Inclusion-based (Andersen-style) points-to analysis on top of a Graph.
+// Variables are the graph's nodes (created on demand from labels) and a
+// copy edge b -> a means pts(b) is a subset of pts(a). The solver runs a
+// worklist with difference propagation: a node only pushes the pointees
+// it gained since it was last processed. Cycles already present in the
+// copy graph are collapsed before solving; later ones are detected
+// lazily (when an edge joins two equal sets) and collapsed online with
+// Graph::merge.
+class AndersenSolver {
+    public:
+        enum ConstraintKind {
+            ADDRESS_OF,     // dst = &src
+            COPY,           // dst = src
+            LOAD,           // dst = *src
+            STORE           // *dst = src
+        };
+
+        struct Stats {
+            std::size_t constraints;
+            std::size_t iterations;       // worklist pops
+            std::size_t propagations;     // pointees pushed along edges
+            std::size_t edgesAdded;       // copy edges from loads/stores
+            std::size_t cyclesCollapsed;
+            std::size_t nodesCollapsed;
+            double seconds;               // total time spent in solve()
+
+            Stats()
+                : constraints(0), iterations(0), propagations(0),
+                  edgesAdded(0), cyclesCollapsed(0), nodesCollapsed(0),
+                  seconds(0) {}
+
+            double constraintsPerSecond() const {
+                return seconds > 0 ? constraints / seconds : 0;
+            }
+        };
+
+    private:
+        struct Constraint {
+            ConstraintKind kind;
+            NodeId dst;
+            NodeId src;
+        };
+
+        Graph& graph;
+        std::vector<Constraint> pending;
+
+        // indexed by graph node id; merged-away ids are left empty
+        std::vector<std::vector<NodeId> > pts;
+        std::vector<std::vector<NodeId> > delta;
+        std::vector<std::vector<NodeId> > loads;    // n -> { a | a = *n }
+        std::vector<std::vector<NodeId> > stores;   // n -> { b | *n = b }
+
+        std::deque<NodeId> worklist;
+        std::vector<char> queued;
+
+        // edges already tried by lazy cycle detection
+        std::unordered_set<uint64_t> checked;
+
+        // scratch for cycle detection, indexed by graph node id
+        std::vector<NodeId> visitIndex;
+        std::vector<NodeId> visitLow;
+        std::vector<char> visitDone;
+
+        Stats stats;
+
+        void grow();
+        void push(NodeId n);
+        void canonicalize(std::vector<NodeId>& ids);
+        bool addCopyEdge(NodeId from, NodeId to);
+        bool propagate(const std::vector<NodeId>& from, NodeId to);
+        bool collapseCycles(const std::vector<NodeId>& roots);
+        void collapse(const std::vector<NodeId>& members);
+
+    public:
+        explicit AndersenSolver(Graph& graph);
+
+        // records a constraint; labels are turned into nodes on demand
+        void addConstraint(ConstraintKind kind, std::string_view dst,
+                           std::string_view src);
+        void addConstraint(ConstraintKind kind, NodeId dst, NodeId src);
+
+        // runs to a fixpoint over every constraint added so far
+        void solve();
+
+        // the objects the variable may point to, ascending. An object is
+        // named by the id its node was created with; Graph::resolve gives
+        // the node that holds it now
+        std::vector<NodeId> pointsTo(NodeId var);
+        std::vector<NodeId> pointsTo(std::string_view label);
+
+        const Stats& getStats() const {
+            return stats;
+        }
+};
+
+#endif
@@ -0,0 +1,298 @@
+/*
+* BFS.cpp
+*/
+#include "BFS.h"
+#include "Parallel.h"
+#include <atomic>
+
+//===-----------------------------------------------------------------===//
+// Direction-optimizing BFS
+//
+// visited is shared by all threads. Top-down steps claim a node with an
+// atomic fetch_or on its word; bottom-up steps split the nodes into runs
+// of whole words, so each word has a single writer.
+
+// tuning from Beamer et al.: go bottom-up when the frontier's out-edges
+// exceed 1/ALPHA of the unexplored edges, and back top-down when the
+// frontier holds fewer than 1/BETA of the nodes
+static const EdgeOffset ALPHA = 14;
+static const NodeId BETA = 24;
+
+// levels narrower than this run on the calling thread
+static const std::size_t PARALLEL_LEVEL = 4096;
+
+typedef std::vector<std::atomic<uint64_t> > AtomicBitmap;
+
+static inline bool
+claim(AtomicBitmap& bitmap, NodeId v)
+{
+    uint64_t bit = (uint64_t) 1 << (v & 63);
+    if (bitmap[v >> 6].load(std::memory_order_relaxed) & bit)
+    {
+        return false;
+    }
+    return !(bitmap[v >> 6].fetch_or(bit, std::memory_order_relaxed) & bit);
+}
+
+static inline bool
+test(const AtomicBitmap& bitmap, NodeId v)
+{
+    return (bitmap[v >> 6].load(std::memory_order_relaxed) >> (v & 63)) & 1;
+}
+
+// runs the search; distance may be NULL when only visited is wanted
+template <class G>
+static void
+traverse(const G& graph, const std::vector<NodeId>& roots,
+         AtomicBitmap& visited, NodeId* distance, unsigned threads)
+{
+    if (threads == 0)
+    {
+        threads = hardwareThreads();
+    }
+    NodeId n = graph.numNodes();
+    std::size_t words = ((std::size_t) n + 63) / 64;
+
+    std::vector<NodeId> queue;
+    EdgeOffset frontierEdges = 0;
+    for (std::size_t i = 0; i < roots.size(); i++)
+    {
+        if (roots[i] < n && claim(visited, roots[i]))
+        {
+            queue.push_back(roots[i]);
+            frontierEdges += graph.outDegree(roots[i]);
+            if (distance != NULL)
+            {
+                distance[roots[i]] = 0;
+            }
+        }
+    }
+
+    AtomicBitmap frontier(0);
+    AtomicBitmap next(0);
+    std::vector<std::vector<NodeId> > found(threads);
+    std::vector<EdgeOffset> foundEdges(threads);
+    std::vector<NodeId> foundCount(threads);
+    EdgeOffset unexplored = graph.numEdges();
+    NodeId frontierSize = (NodeId) queue.size();
+    bool bottomUp = false;
+    NodeId level = 0;
+
+    while (frontierSize > 0)
+    {
+        unexplored -= std::min(unexplored, frontierEdges);
+        if (!bottomUp && frontierEdges > unexplored / ALPHA)
+        {
+            // queue -> bitmap
+            bottomUp = true;
+            if (frontier.size() != words)
+            {
+                AtomicBitmap(words).swap(frontier);
+                AtomicBitmap(words).swap(next);
+            }
+            for (std::size_t w = 0; w < words; w++)
+            {
+                frontier[w].store(0, std::memory_order_relaxed);
+            }
+            for (std::size_t i = 0; i < queue.size(); i++)
+            {
+                frontier[queue[i] >> 6].fetch_or((uint64_t) 1 << (queue[i] & 63),
+                                                 std::memory_order_relaxed);
+            }
+        }
+        else if (bottomUp && frontierSize < n / BETA)
+        {
+            // bitmap -> queue
+            bottomUp = false;
+            queue.clear();
+            for (std::size_t w = 0; w < words; w++)
+            {
+                uint64_t bits = frontier[w].load(std::memory_order_relaxed);
+                while (bits != 0)
+                {
+                    unsigned b = __builtin_ctzll(bits);
+                    bits &= bits - 1;
+                    queue.push_back((NodeId) (w * 64 + b));
+                }
+            }
+        }
+        level++;
+        unsigned levelThreads = frontierSize < PARALLEL_LEVEL ? 1 : threads;
+
+        if (!bottomUp)
+        {
+            parallelFor(0, queue.size(), levelThreads,
+                [&](std::size_t lo, std::size_t hi, unsigned t)
+                {
+                    EdgeOffset edges = 0;
+                    for (std::size_t i = lo; i < hi; i++)
+                    {
+                        typename G::NeighborRange targets = graph.outNeighbors(queue[i]);
+                        typename G::NeighborRange::const_iterator k;
+                        for (k = targets.begin(); k != targets.end(); ++k)
+                        {
+                            NodeId w = *k;
+                            if (claim(visited, w))
+                            {
+                                if (distance != NULL)
+                                {
+                                    distance[w] = level;
+                                }
+                                found[t].push_back(w);
+                                edges += graph.outDegree(w);
+                            }
+                        }
+                    }
+                    foundEdges[t] = edges;
+                });
+            queue.clear();
+            frontierEdges = 0;
+            for (unsigned t = 0; t < levelThreads; t++)
+            {
+                queue.insert(queue.end(), found[t].begin(), found[t].end());
+                found[t].clear();
+                frontierEdges += foundEdges[t];
+            }
+            frontierSize = (NodeId) queue.size();
+        }
+        else
+        {
+            parallelFor(0, words, threads,
+                [&](std::size_t lo, std::size_t hi, unsigned t)
+                {
+                    EdgeOffset edges = 0;
+                    NodeId count = 0;
+                    for (std::size_t w = lo; w < hi; w++)
+                    {
+                        uint64_t seen = visited[w].load(std::memory_order_relaxed);
+                        uint64_t added = 0;
+                        NodeId first = (NodeId) (w * 64);
+                        NodeId last = std::min<NodeId>(n, first + 64);
+                        for (NodeId v = first; v < last; v++)
+                        {
+                            uint64_t bit = (uint64_t) 1 << (v & 63);
+                            if (seen & bit)
+                            {
+                                continue;
+                            }
+                            typename G::NeighborRange sources = graph.inNeighbors(v);
+                            typename G::NeighborRange::const_iterator k;
+                            for (k = sources.begin(); k != sources.end(); ++k)
+                            {
+                                if (test(frontier, *k))
+                                {
+                                    added |= bit;
+                                    if (distance != NULL)
+                                    {
+                                        distance[v] = level;
+                                    }
+                                    edges += graph.outDegree(v);
+                                    count++;
+                                    break;
+                                }
+                            }
+                        }
+                        visited[w].store(seen | added, std::memory_order_relaxed);
+                        next[w].store(added, std::memory_order_relaxed);
+                    }
+                    foundEdges[t] = edges;
+                    foundCount[t] = count;
+                });
+            frontier.swap(next);
+            frontierEdges = 0;
+            frontierSize = 0;
+            unsigned used = (unsigned) std::min<std::size_t>(threads, words);
+            for (unsigned t = 0; t < used; t++)
+            {
+                frontierEdges += foundEdges[t];
+                frontierSize += foundCount[t];
+            }
+        }
+    }
+}
+
+template <class G>
+static void
+reachableFrom(const G& graph, const std::vector<NodeId>& roots,
+              std::vector<uint64_t>& visited, unsigned threads)
+{
+    std::size_t words = ((std::size_t) graph.numNodes() + 63) / 64;
+    AtomicBitmap bitmap(words);
+    traverse(graph, roots, bitmap, NULL, threads);
+    visited.resize(words);
+    for (std::size_t w = 0; w < words; w++)
+    {
+        visited[w] = bitmap[w].load(std::memory_order_relaxed);
+    }
+}
+
+template <class G>
+static void
+distancesFrom(const G& graph, const std::vector<NodeId>& roots,
+              std::vector<NodeId>& distance, unsigned threads)
+{
+    std::size_t words = ((std::size_t) graph.numNodes() + 63) / 64;
+    AtomicBitmap bitmap(words);
+    distance.assign(graph.numNodes(), INVALID_NODE);
+    traverse(graph, roots, bitmap, distance.data(), threads);
+}
+
+void
+bfsReachable(const CSRGraph& graph, const std::vector<NodeId>& roots,
+             std::vector<uint64_t>& visited, unsigned threads)
+{
+    reachableFrom(graph, roots, visited, threads);
+}
+
+void
+bfsReachable(const CompressedCSRGraph& graph, const std::vector<NodeId>& roots,
+             std::vector<uint64_t>& visited, unsigned threads)
+{
+    reachableFrom(graph, roots, visited, threads);
+}
+
+void
+bfsReachable(const KindFilter<CSRGraph>& graph,
+             const std::vector<NodeId>& roots,
+             std::vector<uint64_t>& visited, unsigned threads)
+{
+    reachableFrom(graph, roots, visited, threads);
+}
+
+void
+bfsReachable(const KindFilter<CompressedCSRGraph>& graph,
+             const std::vector<NodeId>& roots,
+             std::vector<uint64_t>& visited, unsigned threads)
+{
+    reachableFrom(graph, roots, visited, threads);
+}
+
+void
+bfsDistances(const CSRGraph& graph, const std::vector<NodeId>& roots,
+             std::vector<NodeId>& distance, unsigned threads)
+{
+    distancesFrom(graph, roots, distance, threads);
+}
+
+void
+bfsDistances(const CompressedCSRGraph& graph, const std::vector<NodeId>& roots,
+             std::vector<NodeId>& distance, unsigned threads)
+{
+    distancesFrom(graph, roots, distance, threads);
+}
+
+void
+bfsDistances(const KindFilter<CSRGraph>& graph,
+             const std::vector<NodeId>& roots,
+             std::vector<NodeId>& distance, unsigned threads)
+{
+    distancesFrom(graph, roots, distance, threads);
+}
+
+void
+bfsDistances(const KindFilter<CompressedCSRGraph>& graph,
+             const std::vector<NodeId>& roots,
+             std::vector<NodeId>& distance, unsigned threads)
+{
+    distancesFrom(graph, roots, distance, threads);
+}
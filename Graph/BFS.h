@@ -0,0 +1,59 @@
+/*
+* BFS.h
+*/
+#ifndef BFS_H_
+#define BFS_H_
+
+#include <stdint.h>
+#include <vector>
+#include "CSRGraph.h"
+#include "CompressedCSRGraph.h"
+#include "KindFilter.h"
+
+// Multi-source breadth-first search over a frozen graph, on several
+// threads. Each level is expanded either top-down (the frontier pushes
+// along out-edges) or bottom-up (every unvisited node looks for a parent
+// in the frontier along its in-edges), switching with the heuristic of
+// direction-optimizing BFS: bottom-up once the frontier's edges outweigh
+// a fraction of the unexplored ones, top-down again once the frontier
+// shrinks. Frontiers are kept as queues top-down and bitmaps bottom-up.
+// Either kind of frozen graph can be searched, whole or through a
+// KindFilter that keeps only some kinds of edge. threads == 0 uses all
+// cores.
+
+// visited receives one bit per node (bit v % 64 of word v / 64), set for
+// every node reachable from one of the roots
+void bfsReachable(const CSRGraph& graph, const std::vector<NodeId>& roots,
+                  std::vector<uint64_t>& visited, unsigned threads = 0);
+void bfsReachable(const CompressedCSRGraph& graph,
+                  const std::vector<NodeId>& roots,
+                  std::vector<uint64_t>& visited, unsigned threads = 0);
+void bfsReachable(const KindFilter<CSRGraph>& graph,
+                  const std::vector<NodeId>& roots,
+                  std::vector<uint64_t>& visited, unsigned threads = 0);
+void bfsReachable(const KindFilter<CompressedCSRGraph>& graph,
+                  const std::vector<NodeId>& roots,
+                  std::vector<uint64_t>& visited, unsigned threads = 0);
+
+// distance receives the number of edges on a shortest path from the
+// nearest root, or INVALID_NODE for nodes that cannot be reached
+void bfsDistances(const CSRGraph& graph, const std::vector<NodeId>& roots,
+                  std::vector<NodeId>& distance, unsigned threads = 0);
+void bfsDistances(const CompressedCSRGraph& graph,
+                  const std::vector<NodeId>& roots,
+                  std::vector<NodeId>& distance, unsigned threads = 0);
+void bfsDistances(const KindFilter<CSRGraph>& graph,
+                  const std::vector<NodeId>& roots,
+                  std::vector<NodeId>& distance, unsigned threads = 0);
+void bfsDistances(const KindFilter<CompressedCSRGraph>& graph,
+                  const std::vector<NodeId>& roots,
+                  std::vector<NodeId>& distance, unsigned threads = 0);
+
+// tests bit v of a bitmap filled by bfsReachable
+inline bool
+bitmapTest(const std::vector<uint64_t>& bitmap, NodeId v)
+{
+    return (bitmap[v >> 6] >> (v & 63)) & 1;
+}
+
+#endif
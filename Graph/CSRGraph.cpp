@@ -0,0 +1,542 @@
+/*
+* CSRGraph.cpp
+*/
+#include "CSRGraph.h"
+#include "Node.h"
+#include "Edge.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//===-----------------------------------------------------------------===//
+/////////////////////////////  CSRGraph Class  ////////////////////////////
+//===-----------------------------------------------------------------===//
+
+CSRGraph::CSRGraph()
+    : nodeCount(0), edgeCount(0),
+      outOffsets(NULL), outTargets(NULL), inOffsets(NULL), inSources(NULL),
+      outKinds(NULL), inKinds(NULL),
+      labelCount(0), labelOffsets(NULL), labelNodes(NULL), labelPool(NULL),
+      bucketCount(0), buckets(NULL),
+      mapping(NULL), mappingSize(0)
+{
+}
+
+CSRGraph::~CSRGraph()
+{
+    if (mapping != NULL)
+    {
+        munmap(mapping, mappingSize);
+    }
+}
+
+CSRGraph*
+CSRGraph::build(const std::vector<Node*>& nodes)
+{
+    CSRGraph* csr = new CSRGraph();
+
+    // assign dense ids in graph order
+    std::size_t i;
+    csr->frozenIdOf.assign(nodes.size(), INVALID_NODE);
+    for (i = 0; i < nodes.size(); i++)
+    {
+        Node* node = nodes[i];
+        if (node != NULL)
+        {
+            csr->frozenIdOf[i] = (NodeId) csr->nodeOf.size();
+            csr->nodeOf.push_back(node);
+        }
+    }
+
+    NodeId n = (NodeId) csr->nodeOf.size();
+    csr->outOffsetStore.resize(n + 1);
+    csr->outOffsetStore[0] = 0;
+
+    for (NodeId v = 0; v < n; v++)
+    {
+        std::vector<Edge*>* outEdges = csr->nodeOf[v]->getOutEdges();
+        for (std::size_t j = 0; j < outEdges->size(); j++)
+        {
+            NodeId target = csr->idOf((*outEdges)[j]->getTarget());
+            // edges to nodes that never made it into the graph are dropped
+            if (target != INVALID_NODE)
+            {
+                csr->outTargetStore.push_back(target);
+                csr->outKindStore.push_back((uint8_t) (*outEdges)[j]->getKind());
+            }
+        }
+        csr->outOffsetStore[v + 1] = csr->outTargetStore.size();
+    }
+
+    csr->buildInEdges();
+    csr->attachStores();
+    return csr;
+}
+
+// counting sort of the out edges by target; sources come out ascending
+void
+CSRGraph::buildInEdges()
+{
+    NodeId n = (NodeId) outOffsetStore.size() - 1;
+    inOffsetStore.assign(n + 1, 0);
+    inSourceStore.resize(outTargetStore.size());
+    inKindStore.resize(outTargetStore.size());
+
+    for (EdgeOffset e = 0; e < outTargetStore.size(); e++)
+    {
+        inOffsetStore[outTargetStore[e] + 1]++;
+    }
+    for (NodeId v = 0; v < n; v++)
+    {
+        inOffsetStore[v + 1] += inOffsetStore[v];
+    }
+
+    std::vector<EdgeOffset> fill(inOffsetStore.begin(), inOffsetStore.end() - 1);
+    for (NodeId v = 0; v < n; v++)
+    {
+        for (EdgeOffset e = outOffsetStore[v]; e < outOffsetStore[v + 1]; e++)
+        {
+            EdgeOffset at = fill[outTargetStore[e]]++;
+            inSourceStore[at] = v;
+            inKindStore[at] = outKindStore[e];
+        }
+    }
+}
+
+void
+CSRGraph::attachStores()
+{
+    nodeCount = (NodeId) outOffsetStore.size() - 1;
+    edgeCount = outTargetStore.size();
+    outOffsets = outOffsetStore.data();
+    outTargets = outTargetStore.data();
+    inOffsets = inOffsetStore.data();
+    inSources = inSourceStore.data();
+    outKinds = outKindStore.data();
+    inKinds = inKindStore.data();
+}
+
+NodeId
+CSRGraph::idOf(Node* node) const
+{
+    NodeId id = node->getId();
+    if (id >= frozenIdOf.size())
+    {
+        return INVALID_NODE;
+    }
+    return frozenIdOf[id];
+}
+
+std::string_view
+CSRGraph::label(NodeId v) const
+{
+    if (labelPool != NULL)
+    {
+        return labelAt(v);
+    }
+    return nodeOf[v]->getLabelRef();
+}
+
+std::size_t
+CSRGraph::memoryUsage() const
+{
+    if (mapping != NULL)
+    {
+        return mappingSize;
+    }
+    return outOffsetStore.capacity() * sizeof(EdgeOffset)
+         + inOffsetStore.capacity() * sizeof(EdgeOffset)
+         + outTargetStore.capacity() * sizeof(NodeId)
+         + inSourceStore.capacity() * sizeof(NodeId)
+         + outKindStore.capacity() + inKindStore.capacity()
+         + nodeOf.capacity() * sizeof(Node*)
+         + frozenIdOf.capacity() * sizeof(NodeId);
+}
+
+//===-----------------------------------------------------------------===//
+// Binary snapshot format
+//
+// A file is a fixed header followed by sections, each starting on an
+// 8-byte boundary, stored in host byte order:
+//   outOffsets  uint64 x (nodes + 1)     outTargets  uint32 x edges
+//   inOffsets   uint64 x (nodes + 1)     inSources   uint32 x edges
+//   outKinds    uint8 x edges            inKinds     uint8 x edges
+//   labelOffsets uint64 x (labels + 1)   labelNodes  uint32 x labels
+//   labelPool   bytes                    buckets     uint32 x buckets
+// buckets is an open-addressing (linear probing) table of label index + 1,
+// 0 meaning empty, so labels can be looked up without building anything.
+
+static const char GRAPH_MAGIC[8] = { 'G', 'R', 'A', 'P', 'H', 'C', 'S', 'R' };
+static const uint32_t GRAPH_FORMAT_VERSION = 2;
+static const uint32_t GRAPH_BYTE_ORDER = 0x01020304u;
+
+struct GraphFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t numNodes;
+    uint64_t numEdges;
+    uint64_t numLabels;
+    uint64_t poolBytes;
+    uint64_t numBuckets;
+    uint64_t outOffsetsAt;
+    uint64_t outTargetsAt;
+    uint64_t inOffsetsAt;
+    uint64_t inSourcesAt;
+    uint64_t outKindsAt;
+    uint64_t inKindsAt;
+    uint64_t labelOffsetsAt;
+    uint64_t labelNodesAt;
+    uint64_t labelPoolAt;
+    uint64_t bucketsAt;
+    uint64_t fileSize;
+};
+
+// FNV-1a
+static uint64_t
+hashLabel(std::string_view label)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (std::size_t i = 0; i < label.size(); i++)
+    {
+        hash ^= (unsigned char) label[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static uint64_t
+alignUp(uint64_t offset)
+{
+    return (offset + 7) & ~(uint64_t) 7;
+}
+
+// writes count bytes and pads the file to the next 8-byte boundary
+static bool
+writeSection(FILE* file, const void* data, uint64_t bytes, uint64_t& at)
+{
+    static const char zeros[8] = { 0 };
+    if (bytes > 0 && fwrite(data, 1, bytes, file) != bytes)
+    {
+        return false;
+    }
+    uint64_t padded = alignUp(at + bytes);
+    if (padded != at + bytes
+        && fwrite(zeros, 1, padded - at - bytes, file) != padded - at - bytes)
+    {
+        return false;
+    }
+    at = padded;
+    return true;
+}
+
+bool
+CSRGraph::save(const std::string& path,
+               const std::vector<std::pair<std::string_view, NodeId> >&
+                   extraLabels) const
+{
+    NodeId n = numNodes();
+
+    // label table: one entry per node, then the extra labels
+    std::vector<std::string_view> labels;
+    std::vector<NodeId> owners;
+    labels.reserve(n + extraLabels.size());
+    owners.reserve(n + extraLabels.size());
+    NodeId v;
+    for (v = 0; v < n; v++)
+    {
+        labels.push_back(label(v));
+        owners.push_back(v);
+    }
+    std::size_t i;
+    for (i = 0; i < extraLabels.size(); i++)
+    {
+        if (extraLabels[i].first != label(extraLabels[i].second))
+        {
+            labels.push_back(extraLabels[i].first);
+            owners.push_back(extraLabels[i].second);
+        }
+    }
+
+    std::vector<uint64_t> labelOffsetTable(labels.size() + 1, 0);
+    for (i = 0; i < labels.size(); i++)
+    {
+        labelOffsetTable[i + 1] = labelOffsetTable[i] + labels[i].size();
+    }
+
+    // twice as many buckets as labels keeps probe sequences short
+    uint64_t numBuckets = 16;
+    while (numBuckets < 2 * labels.size())
+    {
+        numBuckets *= 2;
+    }
+    std::vector<uint32_t> bucketTable(numBuckets, 0);
+    for (i = 0; i < labels.size(); i++)
+    {
+        uint64_t b = hashLabel(labels[i]) & (numBuckets - 1);
+        while (bucketTable[b] != 0)
+        {
+            b = (b + 1) & (numBuckets - 1);
+        }
+        bucketTable[b] = (uint32_t) (i + 1);
+    }
+
+    GraphFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, GRAPH_MAGIC, sizeof(GRAPH_MAGIC));
+    header.version = GRAPH_FORMAT_VERSION;
+    header.byteOrder = GRAPH_BYTE_ORDER;
+    header.numNodes = n;
+    header.numEdges = numEdges();
+    header.numLabels = labels.size();
+    header.poolBytes = labelOffsetTable.back();
+    header.numBuckets = numBuckets;
+
+    uint64_t at = alignUp(sizeof(header));
+    header.outOffsetsAt = at;
+    at = alignUp(at + (n + 1) * sizeof(EdgeOffset));
+    header.outTargetsAt = at;
+    at = alignUp(at + numEdges() * sizeof(NodeId));
+    header.inOffsetsAt = at;
+    at = alignUp(at + (n + 1) * sizeof(EdgeOffset));
+    header.inSourcesAt = at;
+    at = alignUp(at + numEdges() * sizeof(NodeId));
+    header.outKindsAt = at;
+    at = alignUp(at + numEdges());
+    header.inKindsAt = at;
+    at = alignUp(at + numEdges());
+    header.labelOffsetsAt = at;
+    at = alignUp(at + labelOffsetTable.size() * sizeof(uint64_t));
+    header.labelNodesAt = at;
+    at = alignUp(at + owners.size() * sizeof(NodeId));
+    header.labelPoolAt = at;
+    at = alignUp(at + header.poolBytes);
+    header.bucketsAt = at;
+    at = alignUp(at + numBuckets * sizeof(uint32_t));
+    header.fileSize = at;
+
+    std::string temporary = path + ".tmp";
+    FILE* file = fopen(temporary.c_str(), "wb");
+    if (file == NULL)
+    {
+        return false;
+    }
+    std::vector<char> buffer(1 << 20);
+    setvbuf(file, buffer.data(), _IOFBF, buffer.size());
+
+    at = 0;
+    bool ok = writeSection(file, &header, sizeof(header), at)
+        && writeSection(file, outOffsets, (n + 1) * sizeof(EdgeOffset), at)
+        && writeSection(file, outTargets, numEdges() * sizeof(NodeId), at)
+        && writeSection(file, inOffsets, (n + 1) * sizeof(EdgeOffset), at)
+        && writeSection(file, inSources, numEdges() * sizeof(NodeId), at)
+        && writeSection(file, outKinds, numEdges(), at)
+        && writeSection(file, inKinds, numEdges(), at)
+        && writeSection(file, labelOffsetTable.data(),
+                        labelOffsetTable.size() * sizeof(uint64_t), at)
+        && writeSection(file, owners.data(), owners.size() * sizeof(NodeId), at);
+
+    // the pool is written label by label rather than gathered first
+    uint64_t poolStart = at;
+    for (i = 0; ok && i < labels.size(); i++)
+    {
+        ok = labels[i].empty()
+            || fwrite(labels[i].data(), 1, labels[i].size(), file) == labels[i].size();
+    }
+    at = poolStart + header.poolBytes;
+    ok = ok && writeSection(file, NULL, 0, at)
+        && writeSection(file, bucketTable.data(),
+                        numBuckets * sizeof(uint32_t), at);
+
+    ok = (fclose(file) == 0) && ok;
+    ok = ok && std::rename(temporary.c_str(), path.c_str()) == 0;
+    if (!ok)
+    {
+        std::remove(temporary.c_str());
+    }
+    return ok;
+}
+
+// checks that a section of count elements of the given size lies inside
+// the file
+static bool
+sectionFits(uint64_t at, uint64_t count, uint64_t size, uint64_t fileSize)
+{
+    return at % 8 == 0 && at <= fileSize
+        && count <= (fileSize - at) / size;
+}
+
+// offsets of n nodes into total entries: from 0 up to total, in order
+static bool
+offsetsValid(const EdgeOffset* offsets, uint64_t n, uint64_t total)
+{
+    if (offsets[0] != 0 || offsets[n] != total)
+    {
+        return false;
+    }
+    for (uint64_t v = 0; v < n; v++)
+    {
+        if (offsets[v] > offsets[v + 1])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool
+idsBelow(const NodeId* ids, uint64_t count, uint64_t n)
+{
+    for (uint64_t i = 0; i < count; i++)
+    {
+        if (ids[i] >= n)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool
+kindsValid(const uint8_t* kinds, uint64_t count)
+{
+    for (uint64_t i = 0; i < count; i++)
+    {
+        if (kinds[i] != EDGE_MAY && kinds[i] != EDGE_MUST)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// every bucket is empty or names a label, and at least one is empty so
+// that probing ends
+static bool
+bucketsValid(const uint32_t* buckets, uint64_t count, uint64_t labels)
+{
+    uint64_t used = 0;
+    for (uint64_t b = 0; b < count; b++)
+    {
+        if (buckets[b] > labels)
+        {
+            return false;
+        }
+        used += buckets[b] != 0;
+    }
+    return used < count;
+}
+
+// the arrays the header points at, checked before anything indexes
+// through them
+static bool
+contentsValid(const char* bytes, const GraphFileHeader* header)
+{
+    uint64_t n = header->numNodes;
+    uint64_t m = header->numEdges;
+    return offsetsValid((const EdgeOffset*) (bytes + header->outOffsetsAt), n, m)
+        && offsetsValid((const EdgeOffset*) (bytes + header->inOffsetsAt), n, m)
+        && idsBelow((const NodeId*) (bytes + header->outTargetsAt), m, n)
+        && idsBelow((const NodeId*) (bytes + header->inSourcesAt), m, n)
+        && kindsValid((const uint8_t*) (bytes + header->outKindsAt), m)
+        && kindsValid((const uint8_t*) (bytes + header->inKindsAt), m)
+        && offsetsValid((const uint64_t*) (bytes + header->labelOffsetsAt),
+                        header->numLabels, header->poolBytes)
+        && idsBelow((const NodeId*) (bytes + header->labelNodesAt),
+                    header->numLabels, n)
+        && bucketsValid((const uint32_t*) (bytes + header->bucketsAt),
+                        header->numBuckets, header->numLabels);
+}
+
+CSRGraph*
+CSRGraph::load(const std::string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (uint64_t) info.st_size < sizeof(GraphFileHeader))
+    {
+        close(fd);
+        return NULL;
+    }
+    std::size_t size = info.st_size;
+    void* base = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    const GraphFileHeader* header = (const GraphFileHeader*) base;
+    bool valid = std::memcmp(header->magic, GRAPH_MAGIC, sizeof(GRAPH_MAGIC)) == 0
+        && header->version == GRAPH_FORMAT_VERSION
+        && header->byteOrder == GRAPH_BYTE_ORDER
+        && header->fileSize <= size
+        && header->numNodes < INVALID_NODE
+        && header->numLabels >= header->numNodes
+        && header->numBuckets > header->numLabels
+        && (header->numBuckets & (header->numBuckets - 1)) == 0
+        && sectionFits(header->outOffsetsAt, header->numNodes + 1, 8, size)
+        && sectionFits(header->outTargetsAt, header->numEdges, 4, size)
+        && sectionFits(header->inOffsetsAt, header->numNodes + 1, 8, size)
+        && sectionFits(header->inSourcesAt, header->numEdges, 4, size)
+        && sectionFits(header->outKindsAt, header->numEdges, 1, size)
+        && sectionFits(header->inKindsAt, header->numEdges, 1, size)
+        && sectionFits(header->labelOffsetsAt, header->numLabels + 1, 8, size)
+        && sectionFits(header->labelNodesAt, header->numLabels, 4, size)
+        && sectionFits(header->labelPoolAt, header->poolBytes, 1, size)
+        && sectionFits(header->bucketsAt, header->numBuckets, 4, size)
+        && contentsValid((const char*) base, header);
+    if (!valid)
+    {
+        munmap(base, size);
+        return NULL;
+    }
+
+    const char* bytes = (const char*) base;
+    CSRGraph* csr = new CSRGraph();
+    csr->mapping = base;
+    csr->mappingSize = size;
+    csr->nodeCount = (NodeId) header->numNodes;
+    csr->edgeCount = header->numEdges;
+    csr->outOffsets = (const EdgeOffset*) (bytes + header->outOffsetsAt);
+    csr->outTargets = (const NodeId*) (bytes + header->outTargetsAt);
+    csr->inOffsets = (const EdgeOffset*) (bytes + header->inOffsetsAt);
+    csr->inSources = (const NodeId*) (bytes + header->inSourcesAt);
+    csr->outKinds = (const uint8_t*) (bytes + header->outKindsAt);
+    csr->inKinds = (const uint8_t*) (bytes + header->inKindsAt);
+    csr->labelCount = header->numLabels;
+    csr->labelOffsets = (const uint64_t*) (bytes + header->labelOffsetsAt);
+    csr->labelNodes = (const NodeId*) (bytes + header->labelNodesAt);
+    csr->labelPool = bytes + header->labelPoolAt;
+    csr->bucketCount = header->numBuckets;
+    csr->buckets = (const uint32_t*) (bytes + header->bucketsAt);
+    return csr;
+}
+
+NodeId
+CSRGraph::idOfLabel(std::string_view label) const
+{
+    if (buckets == NULL)
+    {
+        return INVALID_NODE;
+    }
+    uint64_t b = hashLabel(label) & (bucketCount - 1);
+    while (buckets[b] != 0)
+    {
+        uint64_t entry = buckets[b] - 1;
+        if (labelAt(entry) == label)
+        {
+            return labelNodes[entry];
+        }
+        b = (b + 1) & (bucketCount - 1);
+    }
+    return INVALID_NODE;
+}
@@ -0,0 +1,196 @@
+/*
+* CSRGraph.h
+*/
+#ifndef CSRGRAPH_H_
+#define CSRGRAPH_H_
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "GraphTypes.h"
+
+class Node;
+
+/////////////////    CSRGraph Class   //////////////////////
+
+// Immutable compressed-sparse-row view of a Graph. Nodes are renumbered
+// with dense ids [0, numNodes()) and both edge directions are stored as
+// contiguous offset/neighbor arrays, so iterating the neighbors of a node
+// is a walk over a plain array with no allocation. The kind of every edge
+// is kept in a parallel byte array per direction (see KindFilter.h).
+// Build one with Graph::freeze(); it does not see later mutations.
+//
+// A snapshot can be written with save() and opened again with load(),
+// which maps the file read-only: the arrays are used in place, so even a
+// very large graph is usable as soon as the mapping is set up.
+class CSRGraph {
+    friend class Graph;
+
+    public:
+        // a [first, last) run of neighbor ids, with the kinds of the
+        // edges to them
+        class NeighborRange {
+            private:
+                const NodeId* first;
+                const NodeId* last;
+                const uint8_t* firstKind;
+
+            public:
+                typedef const NodeId* const_iterator;
+                typedef const uint8_t* KindCursor;
+
+                NeighborRange(const NodeId* first, const NodeId* last,
+                              const uint8_t* firstKind)
+                    : first(first), last(last), firstKind(firstKind) {}
+
+                const NodeId* begin() const { return first; }
+                const NodeId* end() const { return last; }
+                std::size_t size() const { return last - first; }
+                bool empty() const { return first == last; }
+                NodeId operator[](std::size_t i) const { return first[i]; }
+
+                // walks the kinds in step with the neighbors
+                KindCursor kinds() const { return firstKind; }
+                EdgeKind kind(std::size_t i) const {
+                    return (EdgeKind) firstKind[i];
+                }
+        };
+
+    private:
+        // every accessor reads through these; they point either into the
+        // vectors below or into a mapped file
+        NodeId nodeCount;
+        EdgeOffset edgeCount;
+        const EdgeOffset* outOffsets;
+        const NodeId* outTargets;
+        const EdgeOffset* inOffsets;
+        const NodeId* inSources;
+        const uint8_t* outKinds;
+        const uint8_t* inKinds;
+
+        // label table of a loaded file. Entry v < numNodes() is the label
+        // of node v; the rest are other labels that resolve to labelNodes[i]
+        uint64_t labelCount;
+        const uint64_t* labelOffsets;
+        const NodeId* labelNodes;
+        const char* labelPool;
+        uint64_t bucketCount;
+        const uint32_t* buckets;
+
+        std::vector<EdgeOffset> outOffsetStore;
+        std::vector<NodeId> outTargetStore;
+        std::vector<EdgeOffset> inOffsetStore;
+        std::vector<NodeId> inSourceStore;
+        std::vector<uint8_t> outKindStore;
+        std::vector<uint8_t> inKindStore;
+
+        // frozen id -> original Node, and Graph id -> frozen id. Empty for
+        // a loaded file
+        std::vector<Node*> nodeOf;
+        std::vector<NodeId> frozenIdOf;
+
+        void* mapping;
+        std::size_t mappingSize;
+
+        CSRGraph();
+
+        // disallow copies; a CSRGraph may own a mapping
+        CSRGraph(const CSRGraph&);
+        CSRGraph& operator=(const CSRGraph&);
+
+        // builds a snapshot of the given nodes, which are indexed by their
+        // Graph id (NULL entries are skipped)
+        static CSRGraph* build(const std::vector<Node*>& nodes);
+
+        // fills the in-direction arrays from the out-direction ones
+        void buildInEdges();
+
+        // points the views at the owned vectors
+        void attachStores();
+
+    public:
+        ~CSRGraph();
+
+        NodeId numNodes() const {
+            return nodeCount;
+        }
+
+        EdgeOffset numEdges() const {
+            return edgeCount;
+        }
+
+        NeighborRange outNeighbors(NodeId v) const {
+            return NeighborRange(outTargets + outOffsets[v],
+                                 outTargets + outOffsets[v + 1],
+                                 outKinds + outOffsets[v]);
+        }
+
+        NeighborRange inNeighbors(NodeId v) const {
+            return NeighborRange(inSources + inOffsets[v],
+                                 inSources + inOffsets[v + 1],
+                                 inKinds + inOffsets[v]);
+        }
+
+        std::size_t outDegree(NodeId v) const {
+            return outOffsets[v + 1] - outOffsets[v];
+        }
+
+        std::size_t inDegree(NodeId v) const {
+            return inOffsets[v + 1] - inOffsets[v];
+        }
+
+        // given a frozen id, returns the Node it was built from, or NULL
+        // for a snapshot loaded from a file
+        Node* getNode(NodeId v) const {
+            return v < nodeOf.size() ? nodeOf[v] : NULL;
+        }
+
+        // given a Node, returns its frozen id or INVALID_NODE if the
+        // Node was not part of the graph when it was frozen
+        NodeId idOf(Node* node) const;
+
+        // the label of node v
+        std::string_view label(NodeId v) const;
+
+        // given a label, returns the frozen id it resolves to, or
+        // INVALID_NODE. Only loaded files carry a label table
+        NodeId idOfLabel(std::string_view label) const;
+
+        // the label table of a loaded file (see labelNodes above)
+        uint64_t numLabels() const {
+            return labelCount;
+        }
+        std::string_view labelAt(uint64_t i) const {
+            return std::string_view(labelPool + labelOffsets[i],
+                                    labelOffsets[i + 1] - labelOffsets[i]);
+        }
+        NodeId labelNode(uint64_t i) const {
+            return labelNodes[i];
+        }
+
+        // approximate heap footprint of the snapshot, in bytes (a mapped
+        // file counts as its size)
+        std::size_t memoryUsage() const;
+
+        //===---------------------------------------------------------===//
+        // Binary snapshot format
+
+        // writes the snapshot to path. Each node is saved under label(v);
+        // extraLabels lists further labels and the frozen id they resolve
+        // to. The file is written under a temporary name and renamed over
+        // path, so a snapshot of path that is still mapped keeps its old
+        // contents. Returns false if the file could not be written
+        bool save(const std::string& path,
+                  const std::vector<std::pair<std::string_view, NodeId> >&
+                      extraLabels) const;
+
+        // maps a file written by save() read-only and returns a snapshot
+        // over it, or NULL if the file is missing or not a valid snapshot.
+        // Besides the header, one pass checks that offsets are ordered and
+        // in range and that every id, kind and bucket is valid, so a
+        // corrupt file is refused rather than read out of bounds
+        static CSRGraph* load(const std::string& path);
+};
+
+#endif
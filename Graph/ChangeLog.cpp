@@ -0,0 +1,112 @@
+/*
+* ChangeLog.cpp
+*/
+#include "ChangeLog.h"
+#include <algorithm>
+#include <cassert>
+
+//===-----------------------------------------------------------------===//
+////////////////////////////  ChangeLog Class  ////////////////////////////
+//===-----------------------------------------------------------------===//
+
+ChangeLog::ChangeLog(unsigned long version)
+    : firstVersion(version), labelStarts(1, 0), locking(false)
+{
+}
+
+// callers hold the lock if needed. The version only moves forward, so a
+// new mark is needed only when it differs from the last one
+Change&
+ChangeLog::append(unsigned long version, ChangeOp op, NodeId a, NodeId b,
+                  unsigned kind)
+{
+    if (marks.empty() || marks.back().first != version)
+    {
+        assert((marks.empty() || marks.back().first < version)
+               && "versions must not go back");
+        marks.push_back(std::make_pair(version, changes.size()));
+    }
+    Change change;
+    change.op = (uint8_t) op;
+    change.kind = (uint8_t) kind;
+    change.a = a;
+    change.b = b;
+    change.payload = 0;
+    changes.push_back(change);
+    return changes.back();
+}
+
+void
+ChangeLog::record(unsigned long version, ChangeOp op, NodeId a, NodeId b,
+                  unsigned kind)
+{
+    std::unique_lock<std::mutex> guard(lock, std::defer_lock);
+    if (locking)
+    {
+        guard.lock();
+    }
+    append(version, op, a, b, kind);
+}
+
+void
+ChangeLog::recordLabel(unsigned long version, ChangeOp op, NodeId id,
+                       std::string_view label)
+{
+    std::unique_lock<std::mutex> guard(lock, std::defer_lock);
+    if (locking)
+    {
+        guard.lock();
+    }
+    Change& change = append(version, op, id, INVALID_NODE, 0);
+    change.payload = (uint32_t) (labelStarts.size() - 1);
+    labelPool.append(label.data(), label.size());
+    labelStarts.push_back(labelPool.size());
+}
+
+void
+ChangeLog::recordOrder(unsigned long version, NodeId count,
+                       const std::vector<NodeId>& order, bool relocated)
+{
+    Change& change = append(version, CHANGE_RENUMBER, count,
+                            (NodeId) order.size(), relocated ? 1 : 0);
+    change.payload = (uint32_t) orderStarts.size();
+    orderStarts.push_back(orderPool.size());
+    orderPool.insert(orderPool.end(), order.begin(), order.end());
+}
+
+std::size_t
+ChangeLog::since(unsigned long version) const
+{
+    std::vector<std::pair<unsigned long, std::size_t> >::const_iterator it =
+        std::lower_bound(marks.begin(), marks.end(),
+                         std::make_pair(version, (std::size_t) 0));
+    return it == marks.end() ? changes.size() : it->second;
+}
+
+std::string_view
+ChangeLog::label(const Change& change) const
+{
+    assert((change.op == CHANGE_ADD_NODE || change.op == CHANGE_ADD_LABEL)
+           && "change has no label");
+    std::size_t start = labelStarts[change.payload];
+    return std::string_view(labelPool.data() + start,
+                            labelStarts[change.payload + 1] - start);
+}
+
+const NodeId*
+ChangeLog::order(const Change& change) const
+{
+    assert(change.op == CHANGE_RENUMBER && "change has no order");
+    return orderPool.data() + orderStarts[change.payload];
+}
+
+std::size_t
+ChangeLog::memoryUsage() const
+{
+    return changes.capacity() * sizeof(Change)
+         + marks.capacity() * sizeof(marks[0])
+         + labelPool.capacity()
+         + labelStarts.capacity() * sizeof(std::size_t)
+         + orderPool.capacity() * sizeof(NodeId)
+         + orderStarts.capacity() * sizeof(std::size_t);
+}
@@ -0,0 +1,128 @@
+/*
+* ChangeLog.h
+*/
+#ifndef CHANGELOG_H_
+#define CHANGELOG_H_
+
+#include <stdint.h>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "GraphTypes.h"
+
+// mutations recorded in a ChangeLog, with the meaning of a and b
+enum ChangeOp {
+    CHANGE_ADD_NODE,        // node a was created with a label
+    CHANGE_REMOVE_NODE,     // node a was removed together with its edges
+    CHANGE_ADD_EDGE,        // a -> b was added with the given kind
+    CHANGE_REMOVE_EDGE,     // a -> b was removed
+    CHANGE_SET_EDGE_KIND,   // a -> b now has the given kind
+    CHANGE_MERGE,           // b was merged into a and removed
+    CHANGE_TAKE_LABELS,     // the labels of b now resolve to a
+    CHANGE_ADD_LABEL,       // a label now resolves to a
+    CHANGE_RENUMBER         // the a ids were renumbered into b (see order)
+};
+
+// one recorded mutation, 16 bytes
+struct Change {
+    uint8_t op;             // a ChangeOp
+    uint8_t kind;           // EdgeKind of an edge change. For a renumbering,
+                            // 1 if the edges were relocated (reorder)
+    NodeId a;
+    NodeId b;
+    uint32_t payload;       // label or order number, see ChangeLog
+};
+
+/////////////////    ChangeLog Class   //////////////////////
+
+// Append-only record of the mutations made through a Graph (see
+// Graph::recordChanges), for consumers that keep results up to date
+// incrementally instead of recomputing them, and for Graph::replay.
+//
+// Every change is stamped with the graph version it was made at, that
+// is the version before the bump it causes, so the changes a consumer
+// has not seen yet are those from since(v) on, where v is the version
+// it last looked at. Versions are stored once per run of changes, and
+// labels and renumbering orders go to side pools, so a change costs 16
+// bytes plus its label. Merges are single entries; the edges and labels
+// they move are not listed one by one.
+class ChangeLog {
+    private:
+        std::vector<Change> changes;
+
+        // (version, first change made at that version), ascending
+        std::vector<std::pair<unsigned long, std::size_t> > marks;
+        unsigned long firstVersion;
+
+        // label i is labelPool[labelStarts[i] .. labelStarts[i + 1])
+        std::string labelPool;
+        std::vector<std::size_t> labelStarts;
+
+        // order i starts at orderPool[orderStarts[i]]
+        std::vector<NodeId> orderPool;
+        std::vector<std::size_t> orderStarts;
+
+        // taken by record calls while the graph is concurrent
+        bool locking;
+        std::mutex lock;
+
+        Change& append(unsigned long version, ChangeOp op, NodeId a,
+                       NodeId b, unsigned kind);
+
+        // disallow copies, like the Graph it belongs to
+        ChangeLog(const ChangeLog&);
+        ChangeLog& operator=(const ChangeLog&);
+
+    public:
+        // an empty log of a graph currently at the given version
+        explicit ChangeLog(unsigned long version);
+
+        // append one change made while the graph was at version
+        void record(unsigned long version, ChangeOp op, NodeId a,
+                    NodeId b = INVALID_NODE, unsigned kind = 0);
+        void recordLabel(unsigned long version, ChangeOp op, NodeId id,
+                         std::string_view label);
+
+        // a renumbering of count ids (the old numNodeIds()) that gave the
+        // live nodes listed in order the ids 0, 1, ... in that order
+        void recordOrder(unsigned long version, NodeId count,
+                         const std::vector<NodeId>& order, bool relocated);
+
+        // makes the record calls thread-safe (or not)
+        void setConcurrent(bool on) {
+            locking = on;
+        }
+
+        std::size_t size() const {
+            return changes.size();
+        }
+
+        const Change& operator[](std::size_t i) const {
+            return changes[i];
+        }
+
+        // version of the graph when recording started; only changes made
+        // from then on are in the log
+        unsigned long startVersion() const {
+            return firstVersion;
+        }
+
+        // position of the first change made at version or later, or size()
+        // if there is none. Changes before startVersion() are not known,
+        // so a consumer at an older version has to start over
+        std::size_t since(unsigned long version) const;
+
+        // the label of a CHANGE_ADD_NODE or CHANGE_ADD_LABEL
+        std::string_view label(const Change& change) const;
+
+        // the order of a CHANGE_RENUMBER, change.b ids long: new id i was
+        // old id order[i]. Old ids not listed were empty or merged away
+        const NodeId* order(const Change& change) const;
+
+        // approximate heap bytes held by the log
+        std::size_t memoryUsage() const;
+};
+
+#endif
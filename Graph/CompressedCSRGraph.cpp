@@ -0,0 +1,242 @@
+/*
+* CompressedCSRGraph.cpp
+*/
+#include "CompressedCSRGraph.h"
+#include "CSRGraph.h"
+#include "Node.h"
+#include "Edge.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <utility>
+
+//===-----------------------------------------------------------------===//
+//////////////////////////  CompressedCSRGraph Class  /////////////////////
+//===-----------------------------------------------------------------===//
+
+static void
+writeVarint(std::vector<uint8_t>& out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back((uint8_t) (value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((uint8_t) value);
+}
+
+// a neighbor and the kind of the edge to it
+typedef std::vector<std::pair<NodeId, uint8_t> > NeighborList;
+
+// appends the list of node v: doubled length with the must-edge flag,
+// the kind bits if flagged, zigzag distance of the first neighbor from
+// v, then the gaps. list is sorted in place
+static void
+encodeList(std::vector<uint8_t>& out, NodeId v, NeighborList& list)
+{
+    std::sort(list.begin(), list.end());
+    bool hasMust = false;
+    std::size_t i;
+    for (i = 0; i < list.size() && !hasMust; i++)
+    {
+        hasMust = list[i].second == EDGE_MUST;
+    }
+    writeVarint(out, ((uint64_t) list.size() << 1) | (hasMust ? 1 : 0));
+    if (list.empty())
+    {
+        return;
+    }
+    if (hasMust)
+    {
+        std::size_t bits = out.size();
+        out.resize(bits + (list.size() + 7) / 8, 0);
+        for (i = 0; i < list.size(); i++)
+        {
+            if (list[i].second == EDGE_MUST)
+            {
+                out[bits + i / 8] |= (uint8_t) (1 << (i % 8));
+            }
+        }
+    }
+    int64_t delta = (int64_t) list[0].first - (int64_t) v;
+    writeVarint(out, ((uint64_t) delta << 1) ^ (uint64_t) (delta >> 63));
+    for (i = 1; i < list.size(); i++)
+    {
+        writeVarint(out, list[i].first - list[i - 1].first);
+    }
+}
+
+// encodes the lists of nodes [0, n), fill(v, list) supplying each one.
+// Every thread encodes a contiguous block of nodes into its own buffer;
+// the buffers are then appended in order and their offsets shifted.
+// Returns the number of neighbors encoded
+template <class Fill>
+static EdgeOffset
+encodeAll(NodeId n, Fill fill, std::vector<EdgeOffset>& offsets,
+          std::vector<uint8_t>& bytes, unsigned threads)
+{
+    if (threads == 0)
+    {
+        threads = hardwareThreads();
+    }
+    offsets.assign((std::size_t) n + 1, 0);
+    std::vector<std::vector<uint8_t> > parts(threads);
+    std::vector<std::pair<std::size_t, std::size_t> > blocks(threads,
+        std::make_pair((std::size_t) 0, (std::size_t) 0));
+    std::vector<EdgeOffset> counts(threads, 0);
+    parallelFor(0, n, threads,
+        [&](std::size_t lo, std::size_t hi, unsigned t)
+        {
+            NeighborList list;
+            blocks[t] = std::make_pair(lo, hi);
+            for (std::size_t v = lo; v < hi; v++)
+            {
+                list.clear();
+                fill((NodeId) v, list);
+                offsets[v] = parts[t].size();
+                counts[t] += list.size();
+                encodeList(parts[t], (NodeId) v, list);
+            }
+        });
+
+    std::size_t total = 0;
+    EdgeOffset neighbors = 0;
+    for (unsigned t = 0; t < threads; t++)
+    {
+        total += parts[t].size();
+        neighbors += counts[t];
+    }
+    bytes.clear();
+    bytes.reserve(total);
+    for (unsigned t = 0; t < threads; t++)
+    {
+        EdgeOffset base = bytes.size();
+        for (std::size_t v = blocks[t].first; v < blocks[t].second; v++)
+        {
+            offsets[v] += base;
+        }
+        bytes.insert(bytes.end(), parts[t].begin(), parts[t].end());
+        std::vector<uint8_t>().swap(parts[t]);
+    }
+    offsets[n] = bytes.size();
+    return neighbors;
+}
+
+CompressedCSRGraph::CompressedCSRGraph() : nodeCount(0), edgeCount(0)
+{
+}
+
+CompressedCSRGraph*
+CompressedCSRGraph::build(const std::vector<Node*>& nodes, unsigned threads)
+{
+    CompressedCSRGraph* graph = new CompressedCSRGraph();
+
+    // dense ids in graph order, as CSRGraph::build assigns them
+    graph->frozenIdOf.assign(nodes.size(), INVALID_NODE);
+    for (std::size_t i = 0; i < nodes.size(); i++)
+    {
+        if (nodes[i] != NULL)
+        {
+            graph->frozenIdOf[i] = (NodeId) graph->nodeOf.size();
+            graph->nodeOf.push_back(nodes[i]);
+        }
+    }
+    graph->nodeCount = (NodeId) graph->nodeOf.size();
+
+    // edges to nodes outside the graph are dropped from both directions
+    graph->edgeCount = encodeAll(graph->nodeCount,
+        [graph](NodeId v, NeighborList& list)
+        {
+            std::vector<Edge*>* edges = graph->nodeOf[v]->getOutEdges();
+            for (std::size_t j = 0; j < edges->size(); j++)
+            {
+                NodeId w = graph->idOf((*edges)[j]->getTarget());
+                if (w != INVALID_NODE)
+                {
+                    list.push_back(std::make_pair(w,
+                        (uint8_t) (*edges)[j]->getKind()));
+                }
+            }
+        },
+        graph->outOffsets, graph->outBytes, threads);
+    encodeAll(graph->nodeCount,
+        [graph](NodeId v, NeighborList& list)
+        {
+            std::vector<Edge*>* edges = graph->nodeOf[v]->getInEdges();
+            for (std::size_t j = 0; j < edges->size(); j++)
+            {
+                NodeId w = graph->idOf((*edges)[j]->getSource());
+                if (w != INVALID_NODE)
+                {
+                    list.push_back(std::make_pair(w,
+                        (uint8_t) (*edges)[j]->getKind()));
+                }
+            }
+        },
+        graph->inOffsets, graph->inBytes, threads);
+    return graph;
+}
+
+CompressedCSRGraph*
+CompressedCSRGraph::build(const CSRGraph& csr, unsigned threads)
+{
+    CompressedCSRGraph* graph = new CompressedCSRGraph();
+    graph->nodeCount = csr.numNodes();
+    NodeId v;
+    for (v = 0; v < graph->nodeCount && csr.getNode(v) != NULL; v++)
+    {
+        Node* node = csr.getNode(v);
+        if (node->getId() >= graph->frozenIdOf.size())
+        {
+            graph->frozenIdOf.resize(node->getId() + 1, INVALID_NODE);
+        }
+        graph->frozenIdOf[node->getId()] = v;
+        graph->nodeOf.push_back(node);
+    }
+
+    graph->edgeCount = encodeAll(graph->nodeCount,
+        [&csr](NodeId v, NeighborList& list)
+        {
+            CSRGraph::NeighborRange targets = csr.outNeighbors(v);
+            for (std::size_t j = 0; j < targets.size(); j++)
+            {
+                list.push_back(std::make_pair(targets[j],
+                                              (uint8_t) targets.kind(j)));
+            }
+        },
+        graph->outOffsets, graph->outBytes, threads);
+    encodeAll(graph->nodeCount,
+        [&csr](NodeId v, NeighborList& list)
+        {
+            CSRGraph::NeighborRange sources = csr.inNeighbors(v);
+            for (std::size_t j = 0; j < sources.size(); j++)
+            {
+                list.push_back(std::make_pair(sources[j],
+                                              (uint8_t) sources.kind(j)));
+            }
+        },
+        graph->inOffsets, graph->inBytes, threads);
+    return graph;
+}
+
+NodeId
+CompressedCSRGraph::idOf(Node* node) const
+{
+    NodeId id = node->getId();
+    if (id >= frozenIdOf.size())
+    {
+        return INVALID_NODE;
+    }
+    return frozenIdOf[id];
+}
+
+std::size_t
+CompressedCSRGraph::memoryUsage() const
+{
+    return outOffsets.capacity() * sizeof(EdgeOffset)
+         + inOffsets.capacity() * sizeof(EdgeOffset)
+         + outBytes.capacity()
+         + inBytes.capacity()
+         + nodeOf.capacity() * sizeof(Node*)
+         + frozenIdOf.capacity() * sizeof(NodeId);
+}
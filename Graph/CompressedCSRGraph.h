@@ -0,0 +1,226 @@
+/*
+* CompressedCSRGraph.h
+*/
+#ifndef COMPRESSEDCSRGRAPH_H_
+#define COMPRESSEDCSRGRAPH_H_
+
+#include <cstddef>
+#include <vector>
+#include "GraphTypes.h"
+
+class Node;
+class CSRGraph;
+
+/////////////////    CompressedCSRGraph Class   //////////////////////
+
+// Read-only graph with the same traversal interface as CSRGraph, but
+// with every neighbor list sorted and stored as variable-length gaps:
+// a list is its length, the first neighbor as a signed distance from the
+// node itself, then the difference to each next neighbor, all as
+// 7-bit-per-byte varints. Graphs with locality typically need one or two
+// bytes per edge instead of four, plus eight bytes per node and
+// direction for the list offsets. The length is stored doubled, its low
+// bit telling whether a list has must-edges; such a list has one bit
+// per neighbor, set for a must-edge, between its length and its first
+// neighbor, so lists of may-edges only carry no kinds at all.
+//
+// Neighbors are decoded on the fly by a forward iterator, so lists can
+// be walked (range-for, begin()/end()) but not indexed. BFS, SCC and
+// ReachabilityIndex accept either kind of graph.
+class CompressedCSRGraph {
+    friend class Graph;
+
+    public:
+        // reads one varint and advances p past it
+        static uint64_t readVarint(const uint8_t*& p) {
+            uint64_t value = *p++;
+            if (value < 0x80)
+            {
+                return value;
+            }
+            value &= 0x7f;
+            for (unsigned shift = 7; ; shift += 7)
+            {
+                uint64_t byte = *p++;
+                value |= (byte & 0x7f) << shift;
+                if (byte < 0x80)
+                {
+                    return value;
+                }
+            }
+        }
+
+        class NeighborRange {
+            public:
+                // walks the kind bits of a list in step with its neighbors
+                class KindCursor {
+                    private:
+                        const uint8_t* bits;
+                        NodeId index;
+
+                    public:
+                        KindCursor() : bits(NULL), index(0) {}
+                        explicit KindCursor(const uint8_t* bits)
+                            : bits(bits), index(0) {}
+
+                        EdgeKind operator*() const {
+                            return bits != NULL
+                                && ((bits[index >> 3] >> (index & 7)) & 1)
+                                ? EDGE_MUST : EDGE_MAY;
+                        }
+
+                        KindCursor& operator++() {
+                            index++;
+                            return *this;
+                        }
+                };
+
+                // decodes one neighbor per increment
+                class const_iterator {
+                    private:
+                        const uint8_t* next;
+                        NodeId current;
+                        NodeId left;
+
+                    public:
+                        const_iterator() : next(NULL), current(0), left(0) {}
+                        const_iterator(const uint8_t* next, NodeId current,
+                                       NodeId left)
+                            : next(next), current(current), left(left) {}
+
+                        NodeId operator*() const { return current; }
+
+                        const_iterator& operator++() {
+                            if (--left > 0)
+                            {
+                                current += (NodeId) readVarint(next);
+                            }
+                            return *this;
+                        }
+
+                        // only meaningful between iterators of one list
+                        bool operator==(const const_iterator& other) const {
+                            return left == other.left;
+                        }
+                        bool operator!=(const const_iterator& other) const {
+                            return left != other.left;
+                        }
+                };
+
+            private:
+                const uint8_t* first;
+                const uint8_t* kindBits;
+                NodeId owner;
+                NodeId count;
+
+            public:
+                // list points at the first neighbor; kindBits is NULL for
+                // a list of may-edges
+                NeighborRange(const uint8_t* list, const uint8_t* kindBits,
+                              NodeId owner, NodeId count)
+                    : first(list), kindBits(kindBits), owner(owner),
+                      count(count) {}
+
+                const_iterator begin() const {
+                    if (count == 0)
+                    {
+                        return end();
+                    }
+                    const uint8_t* p = first;
+                    uint64_t zigzag = readVarint(p);
+                    int64_t delta = (int64_t) (zigzag >> 1) ^ -(int64_t) (zigzag & 1);
+                    return const_iterator(p, (NodeId) (owner + delta), count);
+                }
+                const_iterator end() const {
+                    return const_iterator();
+                }
+                std::size_t size() const { return count; }
+                bool empty() const { return count == 0; }
+
+                KindCursor kinds() const { return KindCursor(kindBits); }
+        };
+
+    private:
+        NodeId nodeCount;
+        EdgeOffset edgeCount;
+
+        // byte offset of each node's list; entry n is the total size
+        std::vector<EdgeOffset> outOffsets;
+        std::vector<uint8_t> outBytes;
+        std::vector<EdgeOffset> inOffsets;
+        std::vector<uint8_t> inBytes;
+
+        // frozen id -> original Node, and Graph id -> frozen id, as in
+        // CSRGraph. Empty when built from a loaded snapshot
+        std::vector<Node*> nodeOf;
+        std::vector<NodeId> frozenIdOf;
+
+        CompressedCSRGraph();
+
+        // disallow copies
+        CompressedCSRGraph(const CompressedCSRGraph&);
+        CompressedCSRGraph& operator=(const CompressedCSRGraph&);
+
+        // builds a graph over the given nodes, which are indexed by their
+        // Graph id (NULL entries are skipped)
+        static CompressedCSRGraph* build(const std::vector<Node*>& nodes,
+                                         unsigned threads);
+
+        NeighborRange range(const std::vector<EdgeOffset>& offsets,
+                            const std::vector<uint8_t>& bytes, NodeId v) const {
+            const uint8_t* p = bytes.data() + offsets[v];
+            uint64_t header = readVarint(p);
+            NodeId count = (NodeId) (header >> 1);
+            const uint8_t* kindBits = NULL;
+            if (header & 1)
+            {
+                kindBits = p;
+                p += ((std::size_t) count + 7) / 8;
+            }
+            return NeighborRange(p, kindBits, v, count);
+        }
+
+    public:
+        // compresses a frozen or loaded snapshot, encoding on several
+        // threads (0 = all cores). Node ids are kept
+        static CompressedCSRGraph* build(const CSRGraph& graph,
+                                         unsigned threads = 0);
+
+        NodeId numNodes() const {
+            return nodeCount;
+        }
+
+        EdgeOffset numEdges() const {
+            return edgeCount;
+        }
+
+        // neighbors come out in ascending order
+        NeighborRange outNeighbors(NodeId v) const {
+            return range(outOffsets, outBytes, v);
+        }
+
+        NeighborRange inNeighbors(NodeId v) const {
+            return range(inOffsets, inBytes, v);
+        }
+
+        std::size_t outDegree(NodeId v) const {
+            return outNeighbors(v).size();
+        }
+
+        std::size_t inDegree(NodeId v) const {
+            return inNeighbors(v).size();
+        }
+
+        // given a frozen id, returns the Node it was built from, or NULL
+        Node* getNode(NodeId v) const {
+            return v < nodeOf.size() ? nodeOf[v] : NULL;
+        }
+
+        // given a Node, returns its frozen id or INVALID_NODE
+        NodeId idOf(Node* node) const;
+
+        // approximate heap footprint, in bytes
+        std::size_t memoryUsage() const;
+};
+
+#endif
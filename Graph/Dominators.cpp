@@ -0,0 +1,313 @@
+/*
+* Dominators.cpp
+*/
+#include "Dominators.h"
+#include <cassert>
+#include <utility>
+
+//===-----------------------------------------------------------------===//
+// Lengauer-Tarjan
+//
+// After the depth-first search every array is indexed by preorder
+// number, so semidominators compare as plain integers and the arrays
+// only cover the nodes the search reached.
+
+// dominator searches follow out-edges and take predecessors from
+// in-edges; post-dominator searches run the other way round
+template <bool Post, class G>
+static typename G::NeighborRange
+successors(const G& graph, NodeId v)
+{
+    return Post ? graph.inNeighbors(v) : graph.outNeighbors(v);
+}
+
+template <bool Post, class G>
+static typename G::NeighborRange
+predecessors(const G& graph, NodeId v)
+{
+    return Post ? graph.outNeighbors(v) : graph.inNeighbors(v);
+}
+
+// a node on the DFS path, by preorder number, and the successors it has
+// left to visit
+template <class G>
+struct DominatorFrame {
+    NodeId number;
+    typename G::NeighborRange::const_iterator next;
+    typename G::NeighborRange::const_iterator end;
+
+    DominatorFrame(NodeId number, const typename G::NeighborRange& targets)
+        : number(number), next(targets.begin()), end(targets.end()) {}
+};
+
+// returns the node with the smallest semidominator on the forest path
+// from v up to (but not including) its root, compressing the path on the
+// way. The recursive compress() is unrolled onto path: ancestors are
+// collected bottom-up and then updated from the top down
+static NodeId
+eval(NodeId v, std::vector<NodeId>& ancestor, std::vector<NodeId>& label,
+     const std::vector<NodeId>& semi, std::vector<NodeId>& path)
+{
+    if (ancestor[v] == INVALID_NODE)
+    {
+        return v;
+    }
+    NodeId x = v;
+    while (ancestor[ancestor[x]] != INVALID_NODE)
+    {
+        path.push_back(x);
+        x = ancestor[x];
+    }
+    while (!path.empty())
+    {
+        NodeId y = path.back();
+        path.pop_back();
+        NodeId a = ancestor[y];
+        if (semi[label[a]] < semi[label[y]])
+        {
+            label[y] = label[a];
+        }
+        ancestor[y] = ancestor[a];
+    }
+    return label[v];
+}
+
+template <bool Post, class G>
+static void
+lengauerTarjan(const G& graph, NodeId entry, std::vector<NodeId>& idom)
+{
+    NodeId n = graph.numNodes();
+    idom.assign(n, INVALID_NODE);
+    if (entry >= n)
+    {
+        return;
+    }
+
+    // preorder numbering; vertex[i] is the node numbered i
+    std::vector<NodeId> number(n, INVALID_NODE);
+    std::vector<NodeId> vertex;
+    std::vector<NodeId> parent;
+    std::vector<DominatorFrame<G> > frames;
+    number[entry] = 0;
+    vertex.push_back(entry);
+    parent.push_back(INVALID_NODE);
+    frames.push_back(DominatorFrame<G>(0, successors<Post>(graph, entry)));
+    while (!frames.empty())
+    {
+        DominatorFrame<G>& frame = frames.back();
+        if (frame.next == frame.end)
+        {
+            frames.pop_back();
+            continue;
+        }
+        NodeId w = *frame.next;
+        ++frame.next;
+        if (number[w] == INVALID_NODE)
+        {
+            number[w] = (NodeId) vertex.size();
+            vertex.push_back(w);
+            parent.push_back(frame.number);
+            frames.push_back(DominatorFrame<G>(number[w],
+                                               successors<Post>(graph, w)));
+        }
+    }
+
+    NodeId count = (NodeId) vertex.size();
+    std::vector<NodeId> semi(count);
+    std::vector<NodeId> label(count);
+    std::vector<NodeId> ancestor(count, INVALID_NODE);
+    std::vector<NodeId> dom(count, INVALID_NODE);
+    // bucket[i] chains (through bucketNext) the nodes whose
+    // semidominator is i
+    std::vector<NodeId> bucket(count, INVALID_NODE);
+    std::vector<NodeId> bucketNext(count, INVALID_NODE);
+    std::vector<NodeId> path;
+    NodeId w;
+    for (w = 0; w < count; w++)
+    {
+        semi[w] = label[w] = w;
+    }
+
+    for (w = count - 1; w > 0; w--)
+    {
+        typename G::NeighborRange sources =
+            predecessors<Post>(graph, vertex[w]);
+        typename G::NeighborRange::const_iterator it;
+        for (it = sources.begin(); it != sources.end(); ++it)
+        {
+            NodeId v = number[*it];
+            if (v == INVALID_NODE)
+            {
+                continue;
+            }
+            NodeId u = eval(v, ancestor, label, semi, path);
+            if (semi[u] < semi[w])
+            {
+                semi[w] = semi[u];
+            }
+        }
+        bucketNext[w] = bucket[semi[w]];
+        bucket[semi[w]] = w;
+
+        NodeId p = parent[w];
+        ancestor[w] = p;
+        for (NodeId v = bucket[p]; v != INVALID_NODE; v = bucketNext[v])
+        {
+            NodeId u = eval(v, ancestor, label, semi, path);
+            dom[v] = semi[u] < semi[v] ? u : p;
+        }
+        bucket[p] = INVALID_NODE;
+    }
+
+    // nodes whose dominator was deferred take their dominator's one;
+    // preorder guarantees it is final by then
+    dom[0] = 0;
+    for (w = 1; w < count; w++)
+    {
+        if (dom[w] != semi[w])
+        {
+            dom[w] = dom[dom[w]];
+        }
+    }
+    for (w = 0; w < count; w++)
+    {
+        idom[vertex[w]] = vertex[dom[w]];
+    }
+}
+
+//===-----------------------------------------------------------------===//
+// Dominance frontiers
+//
+// A node v is in the frontier of every node on the tree path from each
+// of its predecessors up to, but not including, idom(v). The entry has
+// no dominator, so for it the path runs all the way up and includes the
+// entry itself. Once a walk meets a node whose frontier already holds
+// v, the rest of its path has been covered too, so every (node, v) pair
+// is visited once.
+
+template <bool Post, class G>
+static void
+frontiers(const G& graph, const std::vector<NodeId>& idom,
+          std::vector<EdgeOffset>& offsets, std::vector<NodeId>& frontier)
+{
+    NodeId n = graph.numNodes();
+    assert(idom.size() == n && "dominator tree is for another graph");
+
+    // (node, member) pairs in ascending member order; mark[x] is the
+    // last member added to the frontier of x
+    std::vector<std::pair<NodeId, NodeId> > pairs;
+    std::vector<NodeId> mark(n, INVALID_NODE);
+    NodeId v;
+    for (v = 0; v < n; v++)
+    {
+        if (idom[v] == INVALID_NODE)
+        {
+            continue;
+        }
+        NodeId stop = idom[v] == v ? INVALID_NODE : idom[v];
+        typename G::NeighborRange sources = predecessors<Post>(graph, v);
+        typename G::NeighborRange::const_iterator it;
+        for (it = sources.begin(); it != sources.end(); ++it)
+        {
+            if (idom[*it] == INVALID_NODE)
+            {
+                continue;
+            }
+            for (NodeId runner = *it; runner != stop; runner = idom[runner])
+            {
+                if (mark[runner] == v)
+                {
+                    break;
+                }
+                mark[runner] = v;
+                pairs.push_back(std::make_pair(runner, v));
+                if (idom[runner] == runner)
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    // counting sort by node keeps each frontier ascending
+    offsets.assign((std::size_t) n + 1, 0);
+    std::size_t i;
+    for (i = 0; i < pairs.size(); i++)
+    {
+        offsets[pairs[i].first + 1]++;
+    }
+    for (v = 0; v < n; v++)
+    {
+        offsets[v + 1] += offsets[v];
+    }
+    std::vector<EdgeOffset> fill(offsets.begin(), offsets.end() - 1);
+    frontier.resize(pairs.size());
+    for (i = 0; i < pairs.size(); i++)
+    {
+        frontier[fill[pairs[i].first]++] = pairs[i].second;
+    }
+}
+
+//===-----------------------------------------------------------------===//
+// Entry points
+
+void
+findDominators(const CSRGraph& graph, NodeId entry, std::vector<NodeId>& idom)
+{
+    lengauerTarjan<false>(graph, entry, idom);
+}
+
+void
+findDominators(const CompressedCSRGraph& graph, NodeId entry,
+               std::vector<NodeId>& idom)
+{
+    lengauerTarjan<false>(graph, entry, idom);
+}
+
+void
+findPostDominators(const CSRGraph& graph, NodeId exit,
+                   std::vector<NodeId>& ipdom)
+{
+    lengauerTarjan<true>(graph, exit, ipdom);
+}
+
+void
+findPostDominators(const CompressedCSRGraph& graph, NodeId exit,
+                   std::vector<NodeId>& ipdom)
+{
+    lengauerTarjan<true>(graph, exit, ipdom);
+}
+
+void
+dominanceFrontiers(const CSRGraph& graph, const std::vector<NodeId>& idom,
+                   std::vector<EdgeOffset>& offsets,
+                   std::vector<NodeId>& frontier)
+{
+    frontiers<false>(graph, idom, offsets, frontier);
+}
+
+void
+dominanceFrontiers(const CompressedCSRGraph& graph,
+                   const std::vector<NodeId>& idom,
+                   std::vector<EdgeOffset>& offsets,
+                   std::vector<NodeId>& frontier)
+{
+    frontiers<false>(graph, idom, offsets, frontier);
+}
+
+void
+postDominanceFrontiers(const CSRGraph& graph, const std::vector<NodeId>& ipdom,
+                       std::vector<EdgeOffset>& offsets,
+                       std::vector<NodeId>& frontier)
+{
+    frontiers<true>(graph, ipdom, offsets, frontier);
+}
+
+void
+postDominanceFrontiers(const CompressedCSRGraph& graph,
+                       const std::vector<NodeId>& ipdom,
+                       std::vector<EdgeOffset>& offsets,
+                       std::vector<NodeId>& frontier)
+{
+    frontiers<true>(graph, ipdom, offsets, frontier);
+}
@@ -0,0 +1,51 @@
+/*
+* Dominators.h
+*/
+#ifndef DOMINATORS_H_
+#define DOMINATORS_H_
+
+#include <vector>
+#include "CSRGraph.h"
+#include "CompressedCSRGraph.h"
+
+// Dominator trees of a frozen graph, computed with the Lengauer-Tarjan
+// algorithm (path compression, no balancing) in O(m log n) time. The
+// depth-first search and the path compression are both iterative, so
+// long chains of blocks cannot overflow the call stack.
+//
+// idom[v] receives the immediate dominator of node v. The entry is its
+// own immediate dominator and nodes the entry cannot reach get
+// INVALID_NODE. Post-dominators are the same computation along in-edges
+// from an exit node; a graph with several exits needs a single exit node
+// that they all lead to. Both kinds of frozen graph are accepted.
+void findDominators(const CSRGraph& graph, NodeId entry,
+                    std::vector<NodeId>& idom);
+void findDominators(const CompressedCSRGraph& graph, NodeId entry,
+                    std::vector<NodeId>& idom);
+void findPostDominators(const CSRGraph& graph, NodeId exit,
+                        std::vector<NodeId>& ipdom);
+void findPostDominators(const CompressedCSRGraph& graph, NodeId exit,
+                        std::vector<NodeId>& ipdom);
+
+// Dominance frontiers from a tree computed above, by walking up the tree
+// from the predecessors of every node (Cooper, Harvey and Kennedy). The
+// frontier of v is frontier[offsets[v]] .. frontier[offsets[v + 1] - 1],
+// in ascending order; offsets has numNodes() + 1 entries. The
+// post-dominance frontiers use successors instead of predecessors.
+void dominanceFrontiers(const CSRGraph& graph, const std::vector<NodeId>& idom,
+                        std::vector<EdgeOffset>& offsets,
+                        std::vector<NodeId>& frontier);
+void dominanceFrontiers(const CompressedCSRGraph& graph,
+                        const std::vector<NodeId>& idom,
+                        std::vector<EdgeOffset>& offsets,
+                        std::vector<NodeId>& frontier);
+void postDominanceFrontiers(const CSRGraph& graph,
+                            const std::vector<NodeId>& ipdom,
+                            std::vector<EdgeOffset>& offsets,
+                            std::vector<NodeId>& frontier);
+void postDominanceFrontiers(const CompressedCSRGraph& graph,
+                            const std::vector<NodeId>& ipdom,
+                            std::vector<EdgeOffset>& offsets,
+                            std::vector<NodeId>& frontier);
+
+#endif
@@ -6,10 +6,13 @@
 
 /////////////////    Edge class    ///////////////////////
 
-Edge::Edge(Node * source, Node * target) 
+Edge::Edge(Node * source, Node * target, EdgeKind kind) 
 {
     this->source = source;
     this->target = target;
+    this->outSlot = 0;
+    this->inSlot = 0;
+    this->kind = kind;
 }
 
 Node* 
@@ -4,6 +4,8 @@
 #ifndef EDGE_H_
 #define EDGE_H_
 #include <string>
+#include <cstdint>
+#include "GraphTypes.h"
 #include "Node.h"
 
 class Node;
@@ -11,16 +13,30 @@ class Node;
 // No need to manually create edges. Use Node methods for that
 class Edge {
     friend class Node;
+    friend class Graph;
 
     private:
         Node* target;
         Node* source;
 
+        // positions of this edge in source->outEdges and target->inEdges,
+        // so it can be unlinked from either list in constant time. The
+        // kind shares a word with inSlot, which keeps an Edge at 24 bytes
+        // and caps a node at 2^30 incoming edges
+        uint32_t outSlot;
+        uint32_t inSlot : 30;
+        uint32_t kind : 2;
+
     public:
         Node * getTarget();
         Node * getSource();
 
-        Edge(Node * source, Node * target);
+        // position of this edge in its source's out-edges
+        uint32_t getOutSlot() const { return outSlot; }
+
+        EdgeKind getKind() const { return (EdgeKind) kind; }
+
+        Edge(Node * source, Node * target, EdgeKind kind = EDGE_MAY);
 };
 
 #endif
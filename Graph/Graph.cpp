@@ -1,6 +1,13 @@
 #include "Graph.h"
-#include <fstream>
-#include <iostream>
+#include "Parallel.h"
+#include "SCC.h"
+#include "BFS.h"
+#include "Dominators.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <functional>
+#include <queue>
 
 //===-----------------------------------------------------------------===//
 //////////////////////////    Graph Class   ///////////////////////////////
@@ -9,25 +16,195 @@
 // Graph Constructor
 Graph::Graph(void) 
 {
-    nodes = new std::vector<Node*>();
-    edges = new std::vector<Edge*>();
-    nodeMap = new std::map<std::string, Node*>;
+    allocate();
 }
 
 // Graph copy constructor
 Graph::Graph(const Graph &graph) 
 {
-    nodes = graph.getNodes();
-    edges = graph.getEdges();
-    nodeMap = graph.getNodeMap();
+    allocate();
+    copyFrom(graph);
+}
+
+Graph&
+Graph::operator=(const Graph &graph)
+{
+    if (this != &graph)
+    {
+        release();
+        allocate();
+        copyFrom(graph);
+    }
+    return *this;
 }
 
 // Graph destructor
 Graph::~Graph(void) 
 {
+    release();
+}
+
+// sets up an empty graph
+void
+Graph::allocate()
+{
+    nodes = new std::vector<Node*>();
+    edges = new std::vector<Edge*>();
+    labelIndex = new LabelIndex();
+    classes = new UnionFind();
+    leaders = new std::vector<NodeId>();
+    nodePool = new Slab<Node>();
+    edgePool = new Slab<Edge>();
+    deadSlots = 0;
+    compactThreshold = 0;
+    mergeCount = 0;
+    removeCount = 0;
+    version = 0;
+    frozen = NULL;
+    frozenVersion = 0;
+    compressed = NULL;
+    compressedVersion = 0;
+    reachIndex = NULL;
+    reachIds = new std::vector<NodeId>();
+    reachVersion = 0;
+    reachKinds = ALL_EDGE_KINDS;
+    sliceIds = new std::vector<NodeId>();
+    topoOrder = NULL;
+    concurrent = false;
+    nodeLimit = 0;
+    stripes = NULL;
+    changeLog = NULL;
+}
+
+// Edges are not unlinked one by one: every node drops its lists and the
+// pools hand their blocks back in bulk
+void
+Graph::release()
+{
+    for (std::size_t i = 0; i < nodes->size(); i++)
+    {
+        Node* node = (*nodes)[i];
+        if (node != NULL)
+        {
+            node->forgetEdges();
+            node->~Node();
+        }
+    }
+    delete nodePool;
+    delete edgePool;
     delete nodes;
     delete edges;
-    delete nodeMap;
+    delete labelIndex;
+    delete classes;
+    delete leaders;
+    delete frozen;
+    delete compressed;
+    delete reachIndex;
+    delete reachIds;
+    delete sliceIds;
+    delete topoOrder;
+    delete [] stripes;
+    delete changeLog;
+}
+
+// Nodes keep their ids, including the empty slots, and both edge lists
+// of every node keep their order. The copy of an edge sits at the same
+// slot of its source's out-list as the original, so the in-lists are
+// filled without any lookup. Cached views and indices are not copied;
+// they are rebuilt on first use
+void
+Graph::copyFrom(const Graph &graph)
+{
+    assert(!graph.concurrent && "cannot copy a graph while concurrent");
+    std::size_t n = graph.nodes->size();
+    nodes->assign(n, NULL);
+    std::size_t i;
+    for (i = 0; i < n; i++)
+    {
+        Node* original = (*graph.nodes)[i];
+        if (original != NULL)
+        {
+            Node* node = new (nodePool->allocate()) Node(original->getLabelRef());
+            node->setEdgePool(edgePool);
+            node->setId((NodeId) i);
+            node->getOutEdges()->reserve(original->getOutEdges()->size());
+            node->getInEdges()->reserve(original->getInEdges()->size());
+            (*nodes)[i] = node;
+        }
+    }
+    // the pool is not thread-safe, so every edge gets its slot up front,
+    // in the order the out-lists are filled; both lists are then filled
+    // one node range per thread
+    std::vector<std::size_t> firstEdge(n + 1, 0);
+    for (i = 0; i < n; i++)
+    {
+        Node* original = (*graph.nodes)[i];
+        firstEdge[i + 1] = firstEdge[i]
+            + (original != NULL ? original->getOutEdges()->size() : 0);
+    }
+    std::vector<void*> slots(firstEdge[n]);
+    for (i = 0; i < slots.size(); i++)
+    {
+        slots[i] = edgePool->allocate();
+    }
+    unsigned threads = slots.size() < 65536 ? 1 : hardwareThreads();
+    parallelFor(0, n, threads,
+        [&](std::size_t lo, std::size_t hi, unsigned)
+        {
+            for (std::size_t v = lo; v < hi; v++)
+            {
+                Node* original = (*graph.nodes)[v];
+                if (original == NULL)
+                {
+                    continue;
+                }
+                Node* node = (*nodes)[v];
+                std::vector<Edge*>* out = original->getOutEdges();
+                for (std::size_t k = 0; k < out->size(); k++)
+                {
+                    Node* target = (*nodes)[(*out)[k]->getTarget()->getId()];
+                    Edge* edge = (*out)[k];
+                    node->attachOutEdge(new (slots[firstEdge[v] + k])
+                        Edge(node, target, edge->getKind()));
+                }
+            }
+        });
+    parallelFor(0, n, threads,
+        [&](std::size_t lo, std::size_t hi, unsigned)
+        {
+            for (std::size_t v = lo; v < hi; v++)
+            {
+                Node* original = (*graph.nodes)[v];
+                if (original == NULL)
+                {
+                    continue;
+                }
+                std::vector<Edge*>* in = original->getInEdges();
+                for (std::size_t k = 0; k < in->size(); k++)
+                {
+                    Edge* edge = (*in)[k];
+                    Node* source = (*nodes)[edge->getSource()->getId()];
+                    (*nodes)[v]->attachInEdge(
+                        (*source->getOutEdges())[edge->getOutSlot()]);
+                }
+            }
+        });
+
+    *classes = *graph.classes;
+    *leaders = *graph.leaders;
+    graph.labelIndex->forEach([this](std::string_view label, NodeId id)
+        {
+            labelIndex->assign(label, id);
+        });
+    if (graph.topoOrder != NULL)
+    {
+        topoOrder = new TopologicalOrder(*graph.topoOrder);
+    }
+    deadSlots = graph.deadSlots;
+    compactThreshold = graph.compactThreshold;
+    mergeCount = graph.mergeCount;
+    removeCount = graph.removeCount;
+    version = graph.version;
 }
 
 //===-----------------------------------------------------------------===//
@@ -36,70 +213,378 @@ Graph::~Graph(void)
 Node* 
 Graph::makeNode(std::string label) 
 {
-    // check if already exists
-    Node* newNode = getNodeAtLabel(label);
-    if (newNode == NULL) 
+    // reuses the node if the label already exists
+    NodeId id = internLabel(label);
+    return id == INVALID_NODE ? NULL : (*nodes)[id];
+}
+
+// the node's id is also its slot in nodes
+Node*
+Graph::newNode(std::string label)
+{
+    std::unique_lock<std::mutex> guard(nodeLock, std::defer_lock);
+    if (concurrent)
+    {
+        guard.lock();
+        if (nodes->size() == nodeLimit)
+        {
+            return NULL;
+        }
+    }
+    Node* node = new (nodePool->allocate()) Node(label);
+    node->setEdgePool(edgePool);
+
+    NodeId id = classes->makeSet();
+    node->setId(id);
+    nodes->push_back(node);
+    leaders->push_back(id);
+    if (topoOrder != NULL)
+    {
+        topoOrder->addNode(id);
+    }
+    // still under nodeLock, so the log lists new nodes in id order
+    if (changeLog != NULL)
+    {
+        changeLog->recordLabel(version, CHANGE_ADD_NODE, id,
+                               node->getLabelRef());
+    }
+    if (!concurrent)
     {
-        newNode = new Node(label);
-        (*nodeMap)[label] = newNode;
-        nodes->push_back(newNode);
+        version++;
     }
-    return newNode;
+    return node;
 }
 
-// to create a new node which is the source. Finds the node corresponding
-// to the input target label and attaches the new source node to it.
-// Node is added to the graph.
-void 
-Graph::makeNode(std::string source, std::string target) 
+void
+Graph::destroyNode(Node* thisNode)
 {
-    Node* targetNode = (*nodeMap)[target];
-
-    // check if source already exists
-    Node* sourceNode = getNodeAtLabel(source);
-    if (sourceNode == NULL) 
+    (*nodes)[thisNode->getId()] = NULL;
+    if (topoOrder != NULL)
     {
-        Node * newNode = new Node(source, targetNode);
-        (*nodeMap)[source] = newNode;
-        nodes->push_back(newNode);
+        topoOrder->removeNode(thisNode->getId());
     }
-    else 
+    thisNode->~Node();
+    nodePool->release(thisNode);
+    deadSlots++;
+    version++;
+}
+
+// to create a new node which is the source. Finds the node corresponding
+// to the input target label and attaches the new source node to it.
+// Node is added to the graph. While concurrent either node may be
+// missing once the reserved room is used up; the edge is skipped then
+bool 
+Graph::makeNode(std::string source, std::string target, EdgeKind kind) 
+{
+    Node* targetNode = getNodeAtLabel(target);
+    Node* sourceNode = makeNode(source);
+    if (sourceNode == NULL || targetNode == NULL)
     {
-        createEdge(sourceNode, targetNode);
+        return false;
     }
+    return createEdge(sourceNode, targetNode, kind);
 }
 
-void 
-Graph::makeNodes(std::string source, std::string target) 
+bool 
+Graph::makeNodes(std::string source, std::string target, EdgeKind kind) 
 {
     makeNode(target);
-    makeNode(source, target);
+    return makeNode(source, target, kind);
 }
 
 // given labels corresponding to nodes, this method adds an edge from the
 // source to the target
 bool 
-Graph::createEdge(std::string sourceVar, std::string targetVar) 
+Graph::createEdge(std::string sourceVar, std::string targetVar,
+                  EdgeKind kind) 
 {
-    Node* sourceNode = (*nodeMap)[sourceVar];
-    Node* targetNode = (*nodeMap)[targetVar];
+    Node* sourceNode = getNodeAtLabel(sourceVar);
+    Node* targetNode = getNodeAtLabel(targetVar);
     if (sourceNode == NULL || targetNode == NULL) 
     {
         return false;
     }
-    createEdge(sourceNode, targetNode);
-    return true;
+    return createEdge(sourceNode, targetNode, kind);
 }
 
 // Creates a subtyping edge from src to tgt
 // given nodes, this method adds an edge from the source to the target
-void 
-Graph::createEdge(Node* src, Node* tgt) 
+bool 
+Graph::createEdge(Node* src, Node* tgt, EdgeKind kind) 
 {
+    GRAPH_PROBE(probes, OP_CREATE_EDGE);
     assert(src && "No src node");
     assert(tgt && "No tgt node");
-    src->addTarget(tgt);
-    return;
+    if (concurrent)
+    {
+        // both lists change, so take both stripes, lower one first
+        unsigned a = src->getId() % STRIPES;
+        unsigned b = tgt->getId() % STRIPES;
+        std::unique_lock<std::mutex> first(stripes[std::min(a, b)].lock);
+        std::unique_lock<std::mutex> second;
+        if (a != b)
+        {
+            second = std::unique_lock<std::mutex>(stripes[std::max(a, b)].lock);
+        }
+        if (src->findEdge(tgt) == NULL)
+        {
+            Edge* edge = new (stripes[a].edgePool.allocate())
+                Edge(src, tgt, kind);
+            src->attachOutEdge(edge);
+            tgt->attachInEdge(edge);
+            logChange(CHANGE_ADD_EDGE, src->getId(), tgt->getId(), kind);
+        }
+        return true;
+    }
+    if (src->alreadyHasEdge(tgt))
+    {
+        return true;
+    }
+    if (topoOrder != NULL && !topoOrder->insertEdge(src, tgt))
+    {
+        return false;
+    }
+    // an edge the index does not follow, or one between nodes that
+    // already reach each other, changes no answer, so a current
+    // reachability index survives it
+    bool keepIndex = reachIndex != NULL && reachVersion == version
+        && (!(kind & reachKinds) || reaches(src, tgt, reachKinds));
+    src->addTarget(tgt, kind);
+    logChange(CHANGE_ADD_EDGE, src->getId(), tgt->getId(), kind);
+    version++;
+    if (keepIndex)
+    {
+        reachVersion = version;
+    }
+    return true;
+}
+
+bool
+Graph::setEdgeKind(Node* src, Node* tgt, EdgeKind kind)
+{
+    assert(!concurrent && "setEdgeKind() needs exclusive access");
+    Edge* edge = src->findEdge(tgt);
+    if (edge == NULL)
+    {
+        return false;
+    }
+    if (edge->kind != kind)
+    {
+        edge->kind = kind;
+        logChange(CHANGE_SET_EDGE_KIND, src->getId(), tgt->getId(), kind);
+        version++;
+    }
+    return true;
+}
+
+//===-----------------------------------------------------------------===//
+// Bulk ingestion
+
+void
+Graph::addEdges(const std::vector<std::pair<std::string, std::string> >& edges,
+                unsigned threads, EdgeKind kind)
+{
+    std::vector<std::pair<NodeId, NodeId> > ids;
+    ids.reserve(edges.size());
+    for (std::size_t i = 0; i < edges.size(); i++)
+    {
+        NodeId target = internLabel(edges[i].second);
+        NodeId source = internLabel(edges[i].first);
+        ids.push_back(std::make_pair(source, target));
+    }
+    addEdgeBatch(ids, NULL, kind, threads);
+}
+
+// splits a sorted run into at most `threads` ranges, never separating
+// two entries with the same key, so each range can be handled alone
+template <class T, class Key>
+static std::vector<std::size_t>
+groupBounds(const std::vector<T>& run, unsigned threads, Key key)
+{
+    std::vector<std::size_t> bounds(1, 0);
+    std::size_t chunk = run.size() / threads + 1;
+    while (bounds.back() < run.size())
+    {
+        std::size_t cut = std::min(run.size(), bounds.back() + chunk);
+        while (cut < run.size() && key(run[cut]) == key(run[cut - 1]))
+        {
+            cut++;
+        }
+        bounds.push_back(cut);
+    }
+    return bounds;
+}
+
+void
+Graph::addEdgesById(const std::vector<std::pair<NodeId, NodeId> >& edges,
+                    unsigned threads, EdgeKind kind)
+{
+    addEdgeBatch(edges, NULL, kind, threads);
+}
+
+void
+Graph::addEdgesById(const std::vector<std::pair<NodeId, NodeId> >& edges,
+                    const std::vector<EdgeKind>& kinds, unsigned threads)
+{
+    assert(kinds.size() == edges.size() && "one kind per edge");
+    addEdgeBatch(edges, &kinds, EDGE_MAY, threads);
+}
+
+// Per-pair kinds do not travel with the sorted keys: the keys of the
+// must-pairs and of the may-pairs are sorted apart instead, and walked
+// along with the keys. A key found in both lists gets a may-edge, as
+// when merge() folds two edges that differ in kind
+void
+Graph::addEdgeBatch(const std::vector<std::pair<NodeId, NodeId> >& edges,
+                    const std::vector<EdgeKind>* kinds, EdgeKind kind,
+                    unsigned threads)
+{
+    if (topoOrder != NULL)
+    {
+        for (std::size_t i = 0; i < edges.size(); i++)
+        {
+            createEdgeById(edges[i].first, edges[i].second,
+                           kinds != NULL ? (*kinds)[i] : kind);
+        }
+        return;
+    }
+    if (threads == 0)
+    {
+        threads = hardwareThreads();
+    }
+
+    // pack each live (source, target) pair into one sortable key
+    std::vector<uint64_t> keys;
+    std::vector<uint64_t> mustKeys;
+    std::vector<uint64_t> mayKeys;
+    keys.reserve(edges.size());
+    std::size_t i;
+    for (i = 0; i < edges.size(); i++)
+    {
+        NodeId source = resolve(edges[i].first);
+        NodeId target = resolve(edges[i].second);
+        if (source != INVALID_NODE && target != INVALID_NODE)
+        {
+            keys.push_back(((uint64_t) source << 32) | target);
+            if (kinds != NULL)
+            {
+                ((*kinds)[i] == EDGE_MUST ? mustKeys : mayKeys)
+                    .push_back(keys.back());
+            }
+        }
+    }
+    parallelSort(keys, std::less<uint64_t>(), threads);
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    if (kinds != NULL)
+    {
+        parallelSort(mustKeys, std::less<uint64_t>(), threads);
+        parallelSort(mayKeys, std::less<uint64_t>(), threads);
+    }
+    if (keys.empty())
+    {
+        return;
+    }
+
+    // drop edges the graph already has; lookups are read-only
+    std::vector<char> fresh(keys.size());
+    parallelFor(0, keys.size(), threads,
+        [&](std::size_t lo, std::size_t hi, unsigned)
+        {
+            for (std::size_t k = lo; k < hi; k++)
+            {
+                Node* source = (*nodes)[keys[k] >> 32];
+                Node* target = (*nodes)[(NodeId) keys[k]];
+                fresh[k] = source->findEdge(target) == NULL;
+            }
+        });
+
+    // the pool is not thread-safe, so edges are carved out up front.
+    // Count in-degrees on the way for the target regrouping below
+    std::vector<Edge*> added;
+    added.reserve(keys.size());
+    std::vector<std::size_t> inStart(nodes->size() + 1, 0);
+    std::size_t must = 0;
+    std::size_t may = 0;
+    for (i = 0; i < keys.size(); i++)
+    {
+        EdgeKind edgeKind = kind;
+        if (kinds != NULL)
+        {
+            while (must < mustKeys.size() && mustKeys[must] < keys[i])
+            {
+                must++;
+            }
+            while (may < mayKeys.size() && mayKeys[may] < keys[i])
+            {
+                may++;
+            }
+            bool anyMust = must < mustKeys.size() && mustKeys[must] == keys[i];
+            bool anyMay = may < mayKeys.size() && mayKeys[may] == keys[i];
+            edgeKind = anyMust && !anyMay ? EDGE_MUST : EDGE_MAY;
+        }
+        if (fresh[i])
+        {
+            NodeId target = (NodeId) keys[i];
+            Node* source = (*nodes)[keys[i] >> 32];
+            added.push_back(new (edgePool->allocate())
+                            Edge(source, (*nodes)[target], edgeKind));
+            inStart[target + 1]++;
+        }
+    }
+    std::vector<uint64_t>().swap(mustKeys);
+    std::vector<uint64_t>().swap(mayKeys);
+    if (added.empty())
+    {
+        return;
+    }
+    std::vector<uint64_t>().swap(keys);
+    unsigned workers = added.size() < 65536 ? 1 : threads;
+
+    // out lists: added is ordered by source, one source range per thread
+    std::vector<std::size_t> bounds = groupBounds(added, workers,
+        [](Edge* e) { return e->getSource(); });
+    parallelFor(0, bounds.size() - 1, workers,
+        [&](std::size_t lo, std::size_t hi, unsigned)
+        {
+            for (std::size_t e = bounds[lo]; e < bounds[hi]; e++)
+            {
+                added[e]->getSource()->attachOutEdge(added[e]);
+            }
+        });
+
+    // in lists: counting sort by target (stable, so sources stay
+    // ascending), then one target range per thread
+    for (i = 0; i < nodes->size(); i++)
+    {
+        inStart[i + 1] += inStart[i];
+    }
+    std::vector<Edge*> byTarget(added.size());
+    std::vector<std::size_t> fill(inStart.begin(), inStart.end() - 1);
+    for (i = 0; i < added.size(); i++)
+    {
+        byTarget[fill[added[i]->getTarget()->getId()]++] = added[i];
+    }
+    bounds = groupBounds(byTarget, workers,
+        [](Edge* e) { return e->getTarget(); });
+    parallelFor(0, bounds.size() - 1, workers,
+        [&](std::size_t lo, std::size_t hi, unsigned)
+        {
+            for (std::size_t e = bounds[lo]; e < bounds[hi]; e++)
+            {
+                byTarget[e]->getTarget()->attachInEdge(byTarget[e]);
+            }
+        });
+    if (changeLog != NULL)
+    {
+        for (i = 0; i < added.size(); i++)
+        {
+            changeLog->record(version, CHANGE_ADD_EDGE,
+                              added[i]->getSource()->getId(),
+                              added[i]->getTarget()->getId(),
+                              added[i]->getKind());
+        }
+    }
+    version++;
 }
 
 //===-----------------------------------------------------------------===//
@@ -108,7 +593,7 @@ Graph::createEdge(Node* src, Node* tgt)
 void 
 Graph::removeNode(std::string label) 
 {
-    Node * thisNode = (*nodeMap)[label];
+    Node * thisNode = getNodeAtLabel(label);
     if (thisNode == NULL)
     {
         return;
@@ -120,20 +605,41 @@ Graph::removeNode(std::string label)
     }
 }
 
+// the node's slot is left NULL, and every label that resolved to it
+// now resolves to nothing
 void 
 Graph::removeNode(Node* thisNode) 
 {
-    std::size_t i;
-    for (i = 0; i < nodes->size(); i++) 
+    GRAPH_PROBE(probes, OP_REMOVE_NODE);
+    NodeId id = thisNode->getId();
+    assert(id < nodes->size() && (*nodes)[id] == thisNode && "Not in graph");
+
+    NodeId root = classes->find(id);
+    if ((*leaders)[root] == id)
     {
-        if ((*nodes)[i] == thisNode) 
-        {
-            // we found the Node
-            break;
-        }
+        (*leaders)[root] = INVALID_NODE;
+    }
+    logChange(CHANGE_REMOVE_NODE, id);
+    destroyNode(thisNode);
+    removeCount++;
+    if (compactThreshold > 0 && deadSlots > compactThreshold * nodes->size())
+    {
+        compact();
+    }
+}
+
+// dropping an edge closes no cycle, so a maintained order stays valid
+bool
+Graph::removeEdge(Node* src, Node* tgt)
+{
+    assert(!concurrent && "removeEdge() needs exclusive access");
+    if (!src->removeTarget(tgt))
+    {
+        return false;
     }
-    nodes->erase(nodes->begin() + i);
-    delete thisNode;
+    logChange(CHANGE_REMOVE_EDGE, src->getId(), tgt->getId());
+    version++;
+    return true;
 }
 
 // given the label of a current Node and a new label, this method
@@ -142,19 +648,19 @@ Graph::removeNode(Node* thisNode)
 bool 
 Graph::cloneNode(std::string newLabel, std::string oldLabel) 
 {
-    Node* oldNode = (*nodeMap)[oldLabel];
+    Node* oldNode = getNodeAtLabel(oldLabel);
     if(oldNode == NULL)
     {
         return false;
     }
     Node* newNode = makeNode(newLabel);
-    std::vector<Edge*> oldOutEdges = *(oldNode->getOutEdges());
+    std::vector<Edge*>* oldOutEdges = oldNode->getOutEdges();
 
-    unsigned int i;
-    for (i = 0; i < oldOutEdges.size(); i++) 
+    std::size_t i;
+    for (i = 0; i < oldOutEdges->size(); i++) 
     {
-        Edge currentEdge = *(oldOutEdges[i]);
-        newNode->addTarget(currentEdge.getTarget());
+        Edge* edge = (*oldOutEdges)[i];
+        createEdge(newNode, edge->getTarget(), edge->getKind());
     }
     return true;
 }
@@ -163,11 +669,13 @@ Graph::cloneNode(std::string newLabel, std::string oldLabel)
 // Accesses Node
 
 Node* 
-Graph::getNodeAtLabel(std::string label) 
+Graph::getNodeAtLabel(std::string_view label) 
 {
-    if (nodeMap->find(label) != nodeMap->end()) 
+    GRAPH_PROBE(probes, OP_GET_NODE_AT_LABEL);
+    NodeId id = getIdAtLabel(label);
+    if (id != INVALID_NODE) 
     {
-        return nodeMap->at(label);
+        return (*nodes)[id];
     } 
     else 
     {
@@ -175,160 +683,1286 @@ Graph::getNodeAtLabel(std::string label)
     }
 }
 
-//===-----------------------------------------------------------------===//
+//===----------------------------------------------------------------===//
+// Id-based access
 
-// Given a source Node and a target Node ,
-// this method checks to see if the target needs to be unionized with
-// any of the source's children (at most one),
-// and if so it merges them into the other Node.
-// All nodes that point to the target Node will have their target
-// updated, and the target Node is removed from the graph
-// return true if a merge happened, and false if no merge occurred
-bool 
-Graph::unionize(Node* source, Node* target) 
+NodeId
+Graph::getIdAtLabel(std::string_view label)
 {
-    std::vector<Node *> children = *(source->getOutNodes());
-    for (std::size_t i = 0; i < children.size(); i++) 
+    NodeId id = labelIndex->lookup(label);
+    if (id == INVALID_NODE)
     {
-        Node * currentChild = children[i];
-        merge(currentChild, target);
-        return true;        // only possible to merge with one child
+        return INVALID_NODE;
     }
-    return false;
+    return resolve(id);
 }
 
-// Given nodes A and B, this method merges Node B into Node A.
-// Node A will now have all incoming and outgoing edges that B had.
-// B is removed from the graph.
-void 
-Graph::merge(Node * A, Node* B) 
+NodeId
+Graph::resolve(NodeId id)
 {
-    addTargetsOfOther(A, B);
-    addSourcesOfOther(A,B);
-    takeLabels(A,B);
-    removeNode(B);
-    return;
+    if (concurrent)
+    {
+        // the table may be growing; nothing unites meanwhile
+        return (*leaders)[classes->peek(id)];
+    }
+    if (id >= nodes->size())
+    {
+        return INVALID_NODE;
+    }
+    return (*leaders)[classes->find(id)];
 }
 
-// given vertixes A and B, this method takes all the labels from B and
-// adds them to the list of A's labels. It also updates the nodeMap
-// with this new information
-void 
-Graph::takeLabels(Node * A, Node * B) 
+NodeId
+Graph::internLabel(std::string_view label)
 {
-    std::string currentLabel = B->getLabel();
-    (*nodeMap)[currentLabel] = A; // update the map for each label from B
-    A->takeLabel(B);
-    return;
+    return labelIndex->findOrAdd(label,
+        [this](NodeId id) { return resolve(id); },
+        [this, label]()
+        {
+            Node* node = newNode(std::string(label));
+            return node == NULL ? INVALID_NODE : node->getId();
+        });
 }
 
-// given another Node, this method copies every edge outgoing from the
-// other Node and adds to this one
-void 
-Graph::addTargetsOfOther(Node * thisNode, Node * otherNode) 
+bool
+Graph::createEdgeById(NodeId source, NodeId target, EdgeKind kind)
 {
-    std::vector<Edge*> copyEdges = *(otherNode->getOutEdges());
-
-    for (std::size_t i = 0; i < copyEdges.size(); i++) 
+    // resolve() also skips the bounds check while the table is growing
+    source = resolve(source);
+    target = resolve(target);
+    if (source == INVALID_NODE || target == INVALID_NODE)
     {
-        Edge* edgeToCopy = copyEdges[i];
-        Node * targetNode = edgeToCopy->getTarget();
-
-        if (!thisNode->alreadyHasEdge(targetNode)) 
-        {
-            createEdge(thisNode, targetNode);
-        }
+        return false;
     }
+    return createEdge((*nodes)[source], (*nodes)[target], kind);
 }
 
-// given another Node, this method copies every edge incoming to the other
-// Node and adds to this one
-void 
-Graph::addSourcesOfOther(Node * thisNode, Node * otherNode) 
+void
+Graph::removeNodeById(NodeId id)
 {
-    std::vector<Edge*> copyEdges = *(otherNode->getInEdges());
-    for (std::size_t i = 0; i < copyEdges.size(); i++) 
+    Node* thisNode = getNodeById(id);
+    if (thisNode != NULL)
     {
-        Edge* edgeToCopy = copyEdges[i];
-        edgeToCopy->getSource()->addTarget(thisNode);
+        removeNode(thisNode);
     }
 }
 
-//===-----------------------------------------------------------------===//
-
-void 
-Graph::createDotFile(std::string fileName) 
+std::vector<NodeId>
+Graph::compact()
 {
-    std::ofstream outFile;
-    outFile.open(fileName.c_str());
-
-    outFile << "digraph {\n";
-    outFile << "ordering=out;\nranksep=.3;\n  bgcolor=\"#292929\"; \
-                            node [shape=box, fixedsize=false,\
-                            fontsize=10, \
-                            fontname=\"Courier-Bold\",\
-                            fontcolor=\"grey4\"\n";
-    outFile << "width=.15, height=.15, color=\"#00C389\",\
-                            fillcolor=\"#00C389\",\
-                            style=\"filled, solid, solid\"];\n";
-    outFile << "edge [arrowsize=.4, color=\"firebrick1\",\
-                        style=\"solid\"];\n";
-
-    for (std::size_t i = 0; i < nodes->size(); i++) {
-        Node* currNode = (*nodes)[i];
-        if(currNode != NULL) {
-            std::vector<Edge*>* currEdges = currNode->getOutEdges();
-
-            for (int j = 0; j < (int) currEdges->size(); j++) 
-            {
-                Edge* currEdge = (*currEdges)[j];
-                if(currEdge != NULL) 
-                {
-                    outFile << "\"" << currNode->toString()
-                            << "\"" << " -> "
-                            << "\"" << currEdge->getTarget()->toString()
-                            << "\"" << "\n";
-                }
-            }
+    std::vector<NodeId> order;
+    order.reserve(nodes->size() - deadSlots);
+    for (NodeId id = 0; id < nodes->size(); id++)
+    {
+        if ((*nodes)[id] != NULL)
+        {
+            order.push_back(id);
         }
     }
-    outFile << "}\n";
-    outFile.close();
+    if (changeLog != NULL)
+    {
+        changeLog->recordOrder(version, (NodeId) nodes->size(), order, false);
+    }
+    return renumber(order);
 }
 
-void 
-Graph::printAllNodes()
+std::vector<NodeId>
+Graph::renumber(const std::vector<NodeId>& order)
 {
-    std::cerr << "\nAll Nodes:" << std::endl;
-    for (std::size_t i = 0; i < nodes->size(); i++) 
+    assert(!concurrent && "renumbering needs exclusive access");
+    NodeId oldCount = (NodeId) nodes->size();
+    std::vector<NodeId> newIdOf(oldCount, INVALID_NODE);
+    std::vector<Node*>* live = new std::vector<Node*>();
+    live->reserve(order.size());
+    NodeId id;
+    for (std::size_t i = 0; i < order.size(); i++)
     {
-        Node* currNode = (*nodes)[i];
-        if(currNode != NULL) 
-        {
-            std::cerr << currNode->toString() << std::endl;
-        }
+        Node* node = (*nodes)[order[i]];
+        assert(node != NULL && newIdOf[order[i]] == INVALID_NODE);
+        newIdOf[order[i]] = (NodeId) live->size();
+        node->setId(newIdOf[order[i]]);
+        live->push_back(node);
     }
-}
 
-void 
-Graph::printGraph() 
-{
-    for (std::size_t i = 0; i < nodes->size(); i++) 
+    // old ids follow merges to their live node first
+    std::vector<NodeId> remap(oldCount);
+    for (id = 0; id < oldCount; id++)
     {
-        Node* currNode = (*nodes)[i];
-        if(currNode != NULL)
+        NodeId leader = (*leaders)[classes->find(id)];
+        remap[id] = leader == INVALID_NODE ? INVALID_NODE : newIdOf[leader];
+    }
+
+    // every class is now a single node, so labels point at it directly.
+    // Contents are swapped so that pointers from getNodes() and
+    // getLabelIndex() stay usable
+    LabelIndex labels;
+    labelIndex->forEach([&](std::string_view label, NodeId old)
         {
-            std::vector<Edge*>* currEdges = currNode->getOutEdges();
-            for (int j = 0; j < (int) currEdges->size(); j++) 
+            if (remap[old] != INVALID_NODE)
             {
-                Edge* currEdge = (*currEdges)[j];
-                if(currEdge != NULL) {
-                    std::cerr << "\"" << currNode->toString() << "\""
-                              << " -> "
-                              << "\"" << currEdge->getTarget()->toString()
-                              << "\"" << std::endl;
+                labels.assign(label, remap[old]);
+            }
+        });
+    labelIndex->swap(labels);
+
+    delete classes;
+    classes = new UnionFind();
+    classes->reserve(live->size());
+    leaders->clear();
+    for (id = 0; id < live->size(); id++)
+    {
+        leaders->push_back(classes->makeSet());
+    }
+    nodes->swap(*live);
+    delete live;
+    deadSlots = 0;
+
+    if (topoOrder != NULL)
+    {
+        topoOrder->build(*nodes);
+    }
+    version++;
+    return remap;
+}
+
+//===-----------------------------------------------------------------===//
+// Locality ordering
+
+static std::size_t
+degreeOf(Node* node)
+{
+    return node->getOutEdges()->size() + node->getInEdges()->size();
+}
+
+// calls visit(id) for every neighbor of node, out-edges first
+template <class Visit>
+static void
+forEachNeighbor(Node* node, Visit visit)
+{
+    std::vector<Edge*>* out = node->getOutEdges();
+    std::size_t i;
+    for (i = 0; i < out->size(); i++)
+    {
+        visit((*out)[i]->getTarget()->getId());
+    }
+    std::vector<Edge*>* in = node->getInEdges();
+    for (i = 0; i < in->size(); i++)
+    {
+        visit((*in)[i]->getSource()->getId());
+    }
+}
+
+// order doubles as the BFS queue. Cuthill-McKee takes start nodes by
+// increasing degree, so each component starts from one of its nodes of
+// least degree, and queues the neighbors of a node by increasing degree
+std::vector<NodeId>
+Graph::reorder(ReorderStrategy strategy)
+{
+    assert(!concurrent && "reorder() needs exclusive access");
+    NodeId n = (NodeId) nodes->size();
+    std::vector<NodeId> starts;
+    starts.reserve(n - deadSlots);
+    NodeId id;
+    for (id = 0; id < n; id++)
+    {
+        if ((*nodes)[id] != NULL)
+        {
+            starts.push_back(id);
+        }
+    }
+    std::vector<std::size_t> degree;
+    if (strategy != REORDER_BFS)
+    {
+        degree.assign(n, 0);
+        for (std::size_t i = 0; i < starts.size(); i++)
+        {
+            degree[starts[i]] = degreeOf((*nodes)[starts[i]]);
+        }
+    }
+
+    std::vector<NodeId> order;
+    if (strategy == REORDER_DEGREE)
+    {
+        order = starts;
+        std::stable_sort(order.begin(), order.end(),
+            [&degree](NodeId a, NodeId b) { return degree[a] > degree[b]; });
+    }
+    else
+    {
+        if (strategy == REORDER_RCM)
+        {
+            std::stable_sort(starts.begin(), starts.end(),
+                [&degree](NodeId a, NodeId b) { return degree[a] < degree[b]; });
+        }
+        order.reserve(starts.size());
+        std::vector<char> queued(n, 0);
+        for (std::size_t s = 0; s < starts.size(); s++)
+        {
+            if (queued[starts[s]])
+            {
+                continue;
+            }
+            queued[starts[s]] = 1;
+            order.push_back(starts[s]);
+            for (std::size_t head = order.size() - 1; head < order.size();
+                 head++)
+            {
+                std::size_t first = order.size();
+                forEachNeighbor((*nodes)[order[head]], [&](NodeId w)
+                    {
+                        if (!queued[w])
+                        {
+                            queued[w] = 1;
+                            order.push_back(w);
+                        }
+                    });
+                if (strategy == REORDER_RCM)
+                {
+                    std::stable_sort(order.begin() + first, order.end(),
+                        [&degree](NodeId a, NodeId b)
+                        {
+                            return degree[a] < degree[b];
+                        });
+                }
+            }
+        }
+        if (strategy == REORDER_RCM)
+        {
+            std::reverse(order.begin(), order.end());
+        }
+    }
+    if (changeLog != NULL)
+    {
+        changeLog->recordOrder(version, n, order, true);
+    }
+    std::vector<NodeId> remap = renumber(order);
+    relocateEdges();
+    return remap;
+}
+
+// Each out-edge is copied to its slot in the new pool first. A node's
+// in-edges are then found through their source's out-slot, which the
+// old edges still record, so no node needs a lookup by target
+void
+Graph::relocateEdges()
+{
+    Slab<Edge>* pool = new Slab<Edge>();
+    for (std::size_t v = 0; v < nodes->size(); v++)
+    {
+        (*nodes)[v]->moveOutEdges(pool);
+    }
+
+    // every edge has moved, including those made while concurrent
+    delete edgePool;
+    edgePool = pool;
+    delete [] stripes;
+    stripes = NULL;
+}
+
+//===-----------------------------------------------------------------===//
+// Slices
+
+// edges are read from the out-lists only, so each one is met once, and
+// an edge is kept when its target has a slice id too
+Graph*
+Graph::extract(const std::vector<NodeId>& members,
+               std::vector<NodeId>* originalIds)
+{
+    Graph* slice = new Graph();
+    std::size_t count = members.size();
+    slice->nodes->reserve(count);
+    slice->leaders->reserve(count);
+    slice->classes->reserve(count);
+    std::size_t i;
+    slice->labelIndex->reserve(count);
+    for (i = 0; i < count; i++)
+    {
+        // the original degrees bound the slice's, so no list regrows
+        Node* original = (*nodes)[members[i]];
+        Node* node = slice->newNode(original->getLabelRef());
+        node->getOutEdges()->reserve(original->getOutEdges()->size());
+        node->getInEdges()->reserve(original->getInEdges()->size());
+        slice->labelIndex->assign(original->getLabelRef(), (NodeId) i);
+    }
+    for (i = 0; i < count; i++)
+    {
+        Node* source = (*slice->nodes)[i];
+        std::vector<Edge*>* out = (*nodes)[members[i]]->getOutEdges();
+        for (std::size_t k = 0; k < out->size(); k++)
+        {
+            NodeId target = (*sliceIds)[(*out)[k]->getTarget()->getId()];
+            if (target != INVALID_NODE)
+            {
+                Node* targetNode = (*slice->nodes)[target];
+                Edge* edge = new (slice->edgePool->allocate())
+                    Edge(source, targetNode, (*out)[k]->getKind());
+                source->attachOutEdge(edge);
+                targetNode->attachInEdge(edge);
+            }
+        }
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        (*sliceIds)[members[i]] = INVALID_NODE;
+    }
+    if (originalIds != NULL)
+    {
+        *originalIds = members;
+    }
+    return slice;
+}
+
+Graph*
+Graph::subgraph(const std::vector<NodeId>& ids,
+                std::vector<NodeId>* originalIds)
+{
+    assert(!concurrent && "cannot extract while concurrent");
+    sliceIds->resize(nodes->size(), INVALID_NODE);
+    std::vector<NodeId> members;
+    members.reserve(ids.size());
+    for (std::size_t i = 0; i < ids.size(); i++)
+    {
+        NodeId id = ids[i];
+        if (id < nodes->size() && (*nodes)[id] != NULL
+            && (*sliceIds)[id] == INVALID_NODE)
+        {
+            (*sliceIds)[id] = (NodeId) members.size();
+            members.push_back(id);
+        }
+    }
+    return extract(members, originalIds);
+}
+
+Graph*
+Graph::subgraph(const std::vector<std::string>& labels,
+                std::vector<NodeId>* originalIds)
+{
+    std::vector<NodeId> ids;
+    ids.reserve(labels.size());
+    for (std::size_t i = 0; i < labels.size(); i++)
+    {
+        ids.push_back(getIdAtLabel(labels[i]));
+    }
+    return subgraph(ids, originalIds);
+}
+
+// sliceIds doubles as the visited set of the search, and members as its
+// queue: level by level, each node's neighbors are appended behind it
+Graph*
+Graph::neighborhood(NodeId root, unsigned k, Direction direction,
+                    std::vector<NodeId>* originalIds)
+{
+    assert(!concurrent && "cannot extract while concurrent");
+    sliceIds->resize(nodes->size(), INVALID_NODE);
+    std::vector<NodeId> members;
+    if (root < nodes->size() && (*nodes)[root] != NULL)
+    {
+        (*sliceIds)[root] = 0;
+        members.push_back(root);
+    }
+
+    std::size_t levelStart = 0;
+    for (unsigned level = 0; level < k && levelStart < members.size();
+         level++)
+    {
+        std::size_t levelEnd = members.size();
+        for (std::size_t i = levelStart; i < levelEnd; i++)
+        {
+            Node* node = (*nodes)[members[i]];
+            std::size_t j;
+            if (direction != INCOMING)
+            {
+                std::vector<Edge*>* out = node->getOutEdges();
+                for (j = 0; j < out->size(); j++)
+                {
+                    NodeId id = (*out)[j]->getTarget()->getId();
+                    if ((*sliceIds)[id] == INVALID_NODE)
+                    {
+                        (*sliceIds)[id] = (NodeId) members.size();
+                        members.push_back(id);
+                    }
+                }
+            }
+            if (direction != OUTGOING)
+            {
+                std::vector<Edge*>* in = node->getInEdges();
+                for (j = 0; j < in->size(); j++)
+                {
+                    NodeId id = (*in)[j]->getSource()->getId();
+                    if ((*sliceIds)[id] == INVALID_NODE)
+                    {
+                        (*sliceIds)[id] = (NodeId) members.size();
+                        members.push_back(id);
+                    }
+                }
+            }
+        }
+        levelStart = levelEnd;
+    }
+    return extract(members, originalIds);
+}
+
+//===-----------------------------------------------------------------===//
+// Concurrent mutation
+
+void
+Graph::beginConcurrent(std::size_t maxNewNodes, unsigned shards)
+{
+    if (concurrent)
+    {
+        return;
+    }
+    // edges inserted meanwhile could close cycles in any order
+    dropTopologicalOrder();
+    nodeLimit = nodes->size() + maxNewNodes;
+    nodes->reserve(nodeLimit);
+    leaders->reserve(nodeLimit);
+    classes->reserve(nodeLimit);
+    if (stripes == NULL)
+    {
+        stripes = new Stripe[STRIPES];
+    }
+    labelIndex->setConcurrent(true, shards);
+    if (changeLog != NULL)
+    {
+        changeLog->setConcurrent(true);
+    }
+    concurrent = true;
+}
+
+// the per-call version bumps were skipped, so one bump covers them all
+void
+Graph::endConcurrent()
+{
+    if (!concurrent)
+    {
+        return;
+    }
+    concurrent = false;
+    labelIndex->setConcurrent(false);
+    if (changeLog != NULL)
+    {
+        changeLog->setConcurrent(false);
+    }
+    version++;
+}
+
+//===-----------------------------------------------------------------===//
+
+// Given a source Node and a target Node ,
+// this method checks to see if the target needs to be unionized with
+// any of the source's children (at most one),
+// and if so it merges them into the other Node.
+// All nodes that point to the target Node will have their target
+// updated, and the target Node is removed from the graph
+// return true if a merge happened, and false if no merge occurred
+bool 
+Graph::unionize(Node* source, Node* target) 
+{
+    std::vector<Edge*>* children = source->getOutEdges();
+    if (children->empty())
+    {
+        return false;
+    }
+    // only possible to merge with one child
+    Node * currentChild = (*children)[0]->getTarget();
+    merge(currentChild, target);
+    return true;
+}
+
+// Given nodes A and B, this method merges Node B into Node A.
+// Node A will now have all incoming and outgoing edges that B had.
+// B is removed from the graph. B's edges are rewired in place rather
+// than copied, and B's slot is cleared directly, so a merge costs
+// O(deg(A) + deg(B)) no matter how large the graph is.
+void 
+Graph::merge(Node * A, Node* B) 
+{
+    GRAPH_PROBE(probes, OP_MERGE);
+    if (A == B)
+    {
+        return;
+    }
+    mergeCount++;
+    if (topoOrder != NULL && !orderMerge(A, B))
+    {
+        dropTopologicalOrder();
+    }
+    logChange(CHANGE_MERGE, A->getId(), B->getId());
+    A->absorb(B);
+    uniteLabels(A,B);
+    destroyNode(B);
+    return;
+}
+
+// Two nodes on no common path merge into a node on no cycle. A then
+// gets a copy of every edge of B one at a time, each placed like a new
+// edge, so the order is valid once B is gone; absorb() folds B's own
+// edges into these copies as duplicates
+bool
+Graph::orderMerge(Node* A, Node* B)
+{
+    if (topoOrder->connected(A, B))
+    {
+        return false;
+    }
+    std::vector<Edge*>* edges = B->getInEdges();
+    std::size_t i;
+    for (i = 0; i < edges->size(); i++)
+    {
+        Node* source = (*edges)[i]->getSource();
+        if (!source->alreadyHasEdge(A))
+        {
+            bool placed = topoOrder->insertEdge(source, A);
+            assert(placed && "merge closed a cycle");
+            (void) placed;
+            source->addTarget(A, (*edges)[i]->getKind());
+        }
+    }
+    edges = B->getOutEdges();
+    for (i = 0; i < edges->size(); i++)
+    {
+        Node* target = (*edges)[i]->getTarget();
+        if (!A->alreadyHasEdge(target))
+        {
+            bool placed = topoOrder->insertEdge(A, target);
+            assert(placed && "merge closed a cycle");
+            (void) placed;
+            A->addTarget(target, (*edges)[i]->getKind());
+        }
+    }
+    return true;
+}
+
+// given vertixes A and B, this method takes all the labels from B and
+// adds them to the list of A's labels. B stays live, so the two id
+// classes must stay apart: every label that resolves to B is pointed at
+// A in the index instead, which costs a pass over the labels
+void 
+Graph::takeLabels(Node * A, Node * B) 
+{
+    assert(!concurrent && "takeLabels() needs exclusive access");
+    logChange(CHANGE_TAKE_LABELS, A->getId(), B->getId());
+    if (A != B)
+    {
+        std::vector<std::string_view> moved;
+        labelIndex->forEach([&](std::string_view label, NodeId id)
+            {
+                if (resolve(id) == B->getId())
+                {
+                    moved.push_back(label);
+                }
+            });
+        for (std::size_t i = 0; i < moved.size(); i++)
+        {
+            labelIndex->assign(moved[i], A->getId());
+        }
+    }
+    A->takeLabel(B);
+    version++;
+}
+
+// uniting the two id classes redirects every label of B (and of whatever
+// was merged into B) to A, and every id of B's class as well
+void
+Graph::uniteLabels(Node* A, Node* B)
+{
+    NodeId root = classes->unite(A->getId(), B->getId());
+    (*leaders)[root] = A->getId();
+    A->takeLabel(B);
+    version++;
+    return;
+}
+
+// given another Node, this method copies every edge outgoing from the
+// other Node whose kind is in the mask and adds to this one
+void 
+Graph::addTargetsOfOther(Node * thisNode, Node * otherNode,
+                         EdgeKindMask kinds) 
+{
+    std::vector<Edge*>* copyEdges = otherNode->getOutEdges();
+
+    for (std::size_t i = 0; i < copyEdges->size(); i++) 
+    {
+        Edge* edgeToCopy = (*copyEdges)[i];
+        if (edgeToCopy->getKind() & kinds)
+        {
+            createEdge(thisNode, edgeToCopy->getTarget(),
+                       edgeToCopy->getKind());
+        }
+    }
+}
+
+// given another Node, this method copies every edge incoming to the other
+// Node whose kind is in the mask and adds to this one
+void 
+Graph::addSourcesOfOther(Node * thisNode, Node * otherNode,
+                         EdgeKindMask kinds) 
+{
+    std::vector<Edge*> copyEdges = *(otherNode->getInEdges());
+    for (std::size_t i = 0; i < copyEdges.size(); i++) 
+    {
+        Edge* edgeToCopy = copyEdges[i];
+        if (edgeToCopy->getKind() & kinds)
+        {
+            createEdge(edgeToCopy->getSource(), thisNode,
+                       edgeToCopy->getKind());
+        }
+    }
+}
+
+//===-----------------------------------------------------------------===//
+// Topological order
+
+bool
+Graph::maintainTopologicalOrder()
+{
+    if (topoOrder != NULL)
+    {
+        return true;
+    }
+    topoOrder = new TopologicalOrder();
+    if (!topoOrder->build(*nodes))
+    {
+        dropTopologicalOrder();
+        return false;
+    }
+    return true;
+}
+
+void
+Graph::dropTopologicalOrder()
+{
+    delete topoOrder;
+    topoOrder = NULL;
+}
+
+std::vector<NodeId>
+Graph::topologicalOrder() const
+{
+    if (topoOrder == NULL)
+    {
+        return std::vector<NodeId>();
+    }
+    return topoOrder->nodes();
+}
+
+//===-----------------------------------------------------------------===//
+// Frozen snapshot
+
+const CSRGraph*
+Graph::freeze()
+{
+    if (frozen == NULL || frozenVersion != version)
+    {
+        delete frozen;
+        frozen = CSRGraph::build(*nodes);
+        frozenVersion = version;
+    }
+    return frozen;
+}
+
+const CompressedCSRGraph*
+Graph::freezeCompressed(unsigned threads)
+{
+    if (compressed == NULL || compressedVersion != version)
+    {
+        delete compressed;
+        compressed = CompressedCSRGraph::build(*nodes, threads);
+        compressedVersion = version;
+    }
+    return compressed;
+}
+
+//===-----------------------------------------------------------------===//
+// Strongly connected components
+
+// the search runs over the frozen view, so it never recurses and costs
+// nothing extra when the graph has not changed since the last freeze()
+NodeId
+Graph::findSCCs(std::vector<NodeId>& component, unsigned threads)
+{
+    const CSRGraph* csr = freeze();
+    std::vector<NodeId> frozenComponent;
+    NodeId count = threads == 1
+        ? ::findSCCs(*csr, frozenComponent)
+        : findSCCsParallel(*csr, frozenComponent, threads);
+
+    component.assign(nodes->size(), INVALID_NODE);
+    for (NodeId v = 0; v < csr->numNodes(); v++)
+    {
+        component[csr->getNode(v)->getId()] = frozenComponent[v];
+    }
+    return count;
+}
+
+// each component is merged into its member with the most edges, so the
+// fewest edges are rewired
+std::size_t
+Graph::condense(unsigned threads)
+{
+    std::vector<NodeId> component;
+    NodeId count = findSCCs(component, threads);
+    std::vector<Node*> leader(count, (Node*) NULL);
+
+    NodeId id;
+    for (id = 0; id < component.size(); id++)
+    {
+        if (component[id] == INVALID_NODE)
+        {
+            continue;
+        }
+        Node* node = (*nodes)[id];
+        Node*& best = leader[component[id]];
+        if (best == NULL
+            || node->getOutEdges()->size() + node->getInEdges()->size()
+               > best->getOutEdges()->size() + best->getInEdges()->size())
+        {
+            best = node;
+        }
+    }
+
+    std::size_t merged = 0;
+    for (id = 0; id < component.size(); id++)
+    {
+        if (component[id] == INVALID_NODE)
+        {
+            continue;
+        }
+        Node* best = leader[component[id]];
+        if (best != (*nodes)[id])
+        {
+            merge(best, (*nodes)[id]);
+            merged++;
+        }
+    }
+    return merged;
+}
+
+//===-----------------------------------------------------------------===//
+// Reachability
+//
+// Both searches run over the frozen view. Its ids follow node ids in
+// order, skipping empty slots, so the results only need remapping when
+// the graph has some.
+
+void
+Graph::reachable(const std::vector<NodeId>& roots,
+                 std::vector<uint64_t>& visited, unsigned threads,
+                 EdgeKindMask kinds)
+{
+    const CSRGraph* csr = freeze();
+    std::vector<NodeId> frozenRoots;
+    std::size_t i;
+    for (i = 0; i < roots.size(); i++)
+    {
+        if (roots[i] < csr->frozenIdOf.size()
+            && csr->frozenIdOf[roots[i]] != INVALID_NODE)
+        {
+            frozenRoots.push_back(csr->frozenIdOf[roots[i]]);
+        }
+    }
+    if ((kinds & ALL_EDGE_KINDS) == ALL_EDGE_KINDS)
+    {
+        bfsReachable(*csr, frozenRoots, visited, threads);
+    }
+    else
+    {
+        bfsReachable(KindFilter<CSRGraph>(*csr, kinds), frozenRoots, visited,
+                     threads);
+    }
+    if (csr->numNodes() == nodes->size())
+    {
+        return;
+    }
+
+    std::vector<uint64_t> byId((nodes->size() + 63) / 64, 0);
+    for (NodeId v = 0; v < csr->numNodes(); v++)
+    {
+        if (bitmapTest(visited, v))
+        {
+            NodeId id = csr->nodeOf[v]->getId();
+            byId[id >> 6] |= (uint64_t) 1 << (id & 63);
+        }
+    }
+    visited.swap(byId);
+}
+
+void
+Graph::distances(const std::vector<NodeId>& roots,
+                 std::vector<NodeId>& distance, unsigned threads,
+                 EdgeKindMask kinds)
+{
+    const CSRGraph* csr = freeze();
+    std::vector<NodeId> frozenRoots;
+    std::size_t i;
+    for (i = 0; i < roots.size(); i++)
+    {
+        if (roots[i] < csr->frozenIdOf.size()
+            && csr->frozenIdOf[roots[i]] != INVALID_NODE)
+        {
+            frozenRoots.push_back(csr->frozenIdOf[roots[i]]);
+        }
+    }
+    if ((kinds & ALL_EDGE_KINDS) == ALL_EDGE_KINDS)
+    {
+        bfsDistances(*csr, frozenRoots, distance, threads);
+    }
+    else
+    {
+        bfsDistances(KindFilter<CSRGraph>(*csr, kinds), frozenRoots, distance,
+                     threads);
+    }
+    if (csr->numNodes() == nodes->size())
+    {
+        return;
+    }
+
+    std::vector<NodeId> byId(nodes->size(), INVALID_NODE);
+    for (NodeId v = 0; v < csr->numNodes(); v++)
+    {
+        byId[csr->nodeOf[v]->getId()] = distance[v];
+    }
+    distance.swap(byId);
+}
+
+bool
+Graph::reaches(Node* from, Node* to, EdgeKindMask kinds)
+{
+    return reaches(from->getId(), to->getId(), kinds);
+}
+
+bool
+Graph::reaches(NodeId from, NodeId to, EdgeKindMask kinds)
+{
+    kinds &= ALL_EDGE_KINDS;
+    if (reachIndex == NULL || reachVersion != version || reachKinds != kinds)
+    {
+        const CSRGraph* csr = freeze();
+        delete reachIndex;
+        if (kinds == ALL_EDGE_KINDS)
+        {
+            reachIndex = new ReachabilityIndex(*csr);
+        }
+        else
+        {
+            reachIndex = new ReachabilityIndex(KindFilter<CSRGraph>(*csr, kinds));
+        }
+        *reachIds = csr->frozenIdOf;
+        reachVersion = version;
+        reachKinds = kinds;
+    }
+    if (from >= reachIds->size() || to >= reachIds->size()
+        || (*reachIds)[from] == INVALID_NODE || (*reachIds)[to] == INVALID_NODE)
+    {
+        return false;
+    }
+    return reachIndex->reaches((*reachIds)[from], (*reachIds)[to]);
+}
+
+//===-----------------------------------------------------------------===//
+// Dominators
+
+void
+Graph::treeById(const CSRGraph* csr, std::vector<NodeId>& tree) const
+{
+    std::vector<NodeId> byId(nodes->size(), INVALID_NODE);
+    for (NodeId v = 0; v < csr->numNodes(); v++)
+    {
+        if (tree[v] != INVALID_NODE)
+        {
+            byId[csr->nodeOf[v]->getId()] = csr->nodeOf[tree[v]]->getId();
+        }
+    }
+    tree.swap(byId);
+}
+
+void
+Graph::dominators(NodeId entry, std::vector<NodeId>& idom)
+{
+    const CSRGraph* csr = freeze();
+    NodeId root = entry < csr->frozenIdOf.size()
+        ? csr->frozenIdOf[entry] : INVALID_NODE;
+    findDominators(*csr, root, idom);
+    treeById(csr, idom);
+}
+
+void
+Graph::postDominators(NodeId exit, std::vector<NodeId>& ipdom)
+{
+    const CSRGraph* csr = freeze();
+    NodeId root = exit < csr->frozenIdOf.size()
+        ? csr->frozenIdOf[exit] : INVALID_NODE;
+    findPostDominators(*csr, root, ipdom);
+    treeById(csr, ipdom);
+}
+
+void
+Graph::frontiersById(const std::vector<NodeId>& tree, bool post,
+                     std::vector<EdgeOffset>& offsets,
+                     std::vector<NodeId>& frontier)
+{
+    const CSRGraph* csr = freeze();
+    NodeId n = csr->numNodes();
+    std::vector<NodeId> frozenTree(n, INVALID_NODE);
+    NodeId v;
+    for (v = 0; v < n; v++)
+    {
+        NodeId id = csr->nodeOf[v]->getId();
+        if (id < tree.size() && tree[id] != INVALID_NODE)
+        {
+            frozenTree[v] = csr->frozenIdOf[tree[id]];
+        }
+    }
+    std::vector<EdgeOffset> frozenOffsets;
+    if (post)
+    {
+        ::postDominanceFrontiers(*csr, frozenTree, frozenOffsets, frontier);
+    }
+    else
+    {
+        ::dominanceFrontiers(*csr, frozenTree, frozenOffsets, frontier);
+    }
+
+    // frozen ids follow id order, so the lists stay where they are and
+    // only the offsets spread out over the empty slots
+    std::size_t i;
+    for (i = 0; i < frontier.size(); i++)
+    {
+        frontier[i] = csr->nodeOf[frontier[i]]->getId();
+    }
+    offsets.assign(nodes->size() + 1, 0);
+    for (v = 0; v < n; v++)
+    {
+        offsets[csr->nodeOf[v]->getId() + 1] =
+            frozenOffsets[v + 1] - frozenOffsets[v];
+    }
+    for (i = 0; i < nodes->size(); i++)
+    {
+        offsets[i + 1] += offsets[i];
+    }
+}
+
+void
+Graph::dominanceFrontiers(const std::vector<NodeId>& idom,
+                          std::vector<EdgeOffset>& offsets,
+                          std::vector<NodeId>& frontier)
+{
+    frontiersById(idom, false, offsets, frontier);
+}
+
+void
+Graph::postDominanceFrontiers(const std::vector<NodeId>& ipdom,
+                              std::vector<EdgeOffset>& offsets,
+                              std::vector<NodeId>& frontier)
+{
+    frontiersById(ipdom, true, offsets, frontier);
+}
+
+//===-----------------------------------------------------------------===//
+// Binary snapshots
+
+bool
+Graph::save(const std::string& path)
+{
+    const CSRGraph* csr = freeze();
+
+    std::vector<std::pair<std::string_view, NodeId> > extraLabels;
+    extraLabels.reserve(labelIndex->size());
+    labelIndex->forEach([&](std::string_view label, NodeId id)
+        {
+            id = resolve(id);
+            if (id != INVALID_NODE)
+            {
+                extraLabels.push_back(std::make_pair(label, csr->frozenIdOf[id]));
+            }
+        });
+    return csr->save(path, extraLabels);
+}
+
+bool
+Graph::load(const std::string& path)
+{
+    CSRGraph* csr = CSRGraph::load(path);
+    if (csr == NULL)
+    {
+        return false;
+    }
+
+    NodeId n = csr->numNodes();
+    std::vector<NodeId> idOf(n);
+    NodeId v;
+    for (v = 0; v < n; v++)
+    {
+        idOf[v] = internLabel(csr->label(v));
+    }
+    for (uint64_t i = n; i < csr->numLabels(); i++)
+    {
+        if (labelIndex->lookup(csr->labelAt(i)) == INVALID_NODE)
+        {
+            labelIndex->assign(csr->labelAt(i), idOf[csr->labelNode(i)]);
+            if (changeLog != NULL)
+            {
+                changeLog->recordLabel(version, CHANGE_ADD_LABEL,
+                                       idOf[csr->labelNode(i)],
+                                       csr->labelAt(i));
+            }
+            version++;
+        }
+    }
+
+    std::vector<std::pair<NodeId, NodeId> > edgeList;
+    std::vector<EdgeKind> kinds;
+    edgeList.reserve(csr->numEdges());
+    kinds.reserve(csr->numEdges());
+    for (v = 0; v < n; v++)
+    {
+        CSRGraph::NeighborRange targets = csr->outNeighbors(v);
+        for (std::size_t j = 0; j < targets.size(); j++)
+        {
+            edgeList.push_back(std::make_pair(idOf[v], idOf[targets[j]]));
+            kinds.push_back((EdgeKind) targets.kind(j));
+        }
+    }
+    delete csr;
+    addEdgesById(edgeList, kinds);
+    return true;
+}
+
+//===-----------------------------------------------------------------===//
+// Change log
+
+void
+Graph::recordChanges(bool on)
+{
+    assert(!concurrent && "recordChanges() needs exclusive access");
+    if (!on)
+    {
+        delete changeLog;
+        changeLog = NULL;
+    }
+    else if (changeLog == NULL)
+    {
+        changeLog = new ChangeLog(version);
+    }
+}
+
+bool
+Graph::replay(const ChangeLog& log, std::size_t first)
+{
+    assert(!concurrent && "replay() needs exclusive access");
+    assert(&log != changeLog && "cannot replay a graph onto itself");
+    double threshold = compactThreshold;
+    compactThreshold = 0;
+    bool applied = true;
+    for (std::size_t i = first; applied && i < log.size(); i++)
+    {
+        applied = applyChange(log, log[i]);
+    }
+    compactThreshold = threshold;
+    return applied;
+}
+
+// Every change goes through the public mutators, so this graph records
+// it in turn if it has a log. New nodes get the next free id, which
+// matches the logged one exactly when the two graphs are in step
+bool
+Graph::applyChange(const ChangeLog& log, const Change& change)
+{
+    Node* a = change.op == CHANGE_RENUMBER ? NULL : getNodeById(change.a);
+    Node* b = getNodeById(change.b);
+    switch (change.op)
+    {
+        case CHANGE_ADD_NODE:
+            return internLabel(log.label(change)) == change.a;
+        case CHANGE_REMOVE_NODE:
+            if (a == NULL)
+            {
+                return false;
+            }
+            removeNode(a);
+            return true;
+        case CHANGE_ADD_EDGE:
+            return a != NULL && b != NULL && !a->alreadyHasEdge(b)
+                && createEdge(a, b, (EdgeKind) change.kind);
+        case CHANGE_REMOVE_EDGE:
+            return a != NULL && b != NULL && removeEdge(a, b);
+        case CHANGE_SET_EDGE_KIND:
+            return a != NULL && b != NULL
+                && setEdgeKind(a, b, (EdgeKind) change.kind);
+        case CHANGE_MERGE:
+            if (a == NULL || b == NULL || a == b)
+            {
+                return false;
+            }
+            merge(a, b);
+            return true;
+        case CHANGE_TAKE_LABELS:
+            if (a == NULL || b == NULL)
+            {
+                return false;
+            }
+            takeLabels(a, b);
+            return true;
+        case CHANGE_ADD_LABEL:
+            if (a == NULL)
+            {
+                return false;
+            }
+            labelIndex->assign(log.label(change), change.a);
+            if (changeLog != NULL)
+            {
+                changeLog->recordLabel(version, CHANGE_ADD_LABEL, change.a,
+                                       log.label(change));
+            }
+            version++;
+            return true;
+        case CHANGE_RENUMBER:
+        {
+            if (change.a != nodes->size() || change.b != numLiveNodes())
+            {
+                return false;
+            }
+            const NodeId* listed = log.order(change);
+            std::vector<NodeId> order(listed, listed + change.b);
+            std::vector<char> seen(nodes->size(), 0);
+            for (std::size_t i = 0; i < order.size(); i++)
+            {
+                if (order[i] >= nodes->size() || (*nodes)[order[i]] == NULL
+                    || seen[order[i]])
+                {
+                    return false;
                 }
+                seen[order[i]] = 1;
+            }
+            if (changeLog != NULL)
+            {
+                changeLog->recordOrder(version, change.a, order,
+                                       change.kind != 0);
+            }
+            renumber(order);
+            if (change.kind != 0)
+            {
+                relocateEdges();
+            }
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+//===-----------------------------------------------------------------===//
+// Statistics
+
+// the top nodes are kept in a min-heap of at most topCount entries, so
+// the pass over the nodes never sorts them all
+GraphStats
+Graph::stats(std::size_t topCount) const
+{
+    assert(!concurrent && "cannot take stats while concurrent");
+    GraphStats result;
+    result.idSlots = nodes->size();
+    result.labels = labelIndex->size();
+
+    typedef std::pair<std::size_t, NodeId> Ranked;
+    std::priority_queue<Ranked, std::vector<Ranked>, std::greater<Ranked> > top;
+    for (std::size_t i = 0; i < nodes->size(); i++)
+    {
+        Node* node = (*nodes)[i];
+        if (node == NULL)
+        {
+            continue;
+        }
+        std::size_t out = node->getOutEdges()->size();
+        std::size_t in = node->getInEdges()->size();
+        result.nodes++;
+        result.edges += out;
+        addToHistogram(result.outDegrees, out);
+        addToHistogram(result.inDegrees, in);
+        result.maxOutDegree = std::max(result.maxOutDegree, out);
+        result.maxInDegree = std::max(result.maxInDegree, in);
+        result.adjacencyBytes += node->adjacencyBytes();
+        if (topCount > 0)
+        {
+            top.push(Ranked(out + in, node->getId()));
+            if (top.size() > topCount)
+            {
+                top.pop();
             }
         }
     }
+    for (; !top.empty(); top.pop())
+    {
+        Node* node = (*nodes)[top.top().second];
+        DegreeEntry entry;
+        entry.id = node->getId();
+        entry.label = node->getLabelRef();
+        entry.outDegree = node->getOutEdges()->size();
+        entry.inDegree = node->getInEdges()->size();
+        result.topNodes.push_back(entry);
+    }
+    std::reverse(result.topNodes.begin(), result.topNodes.end());
+
+    result.nodeBytes = nodePool->bytesReserved();
+    result.edgeBytes = edgePool->bytesReserved();
+    if (stripes != NULL)
+    {
+        for (unsigned s = 0; s < STRIPES; s++)
+        {
+            result.edgeBytes += stripes[s].edgePool.bytesReserved();
+        }
+    }
+    result.labelBytes = labelIndex->memoryUsage();
+    result.idBytes = nodes->capacity() * sizeof(Node*)
+                   + classes->capacity() * (sizeof(NodeId) + 1)
+                   + leaders->capacity() * sizeof(NodeId)
+                   + reachIds->capacity() * sizeof(NodeId)
+                   + sliceIds->capacity() * sizeof(NodeId);
+    result.cacheBytes = (frozen != NULL ? frozen->memoryUsage() : 0)
+                      + (compressed != NULL ? compressed->memoryUsage() : 0)
+                      + (reachIndex != NULL ? reachIndex->memoryUsage() : 0);
+    result.logBytes = changeLog != NULL ? changeLog->memoryUsage() : 0;
+    result.merges = mergeCount;
+    result.removals = removeCount;
+    for (int op = 0; op < GRAPH_OP_COUNT; op++)
+    {
+        result.ops[op].calls = probes[op].calls.load(std::memory_order_relaxed);
+        result.ops[op].nanoseconds =
+            probes[op].nanoseconds.load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+//===-----------------------------------------------------------------===//
+
+// the output goes through GraphExporter over the frozen view: labels are
+// copied straight into a large buffer and written in big blocks
+bool 
+Graph::createDotFile(std::string fileName) 
+{
+    return createDotFile(fileName, ExportOptions());
+}
+
+bool
+Graph::createDotFile(std::string fileName, const ExportOptions& options)
+{
+    GraphExporter exporter(*freeze(), options);
+    return exporter.writeDot(fileName);
+}
+
+void 
+Graph::printAllNodes()
+{
+    fputs("\nAll Nodes:\n", stderr);
+    GraphExporter exporter(*freeze());
+    exporter.writeNodeList(stderr);
+}
+
+void 
+Graph::printGraph() 
+{
+    GraphExporter exporter(*freeze());
+    exporter.writeEdgeList(stderr);
 }
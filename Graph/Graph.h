@@ -1,9 +1,23 @@
+#ifndef GRAPH_H_
+#define GRAPH_H_
+
+#include <mutex>
 #include <vector>
 #include <string>
-#include <map>
+#include <string_view>
 
 #include "Edge.h"
 #include "Node.h"
+#include "CSRGraph.h"
+#include "CompressedCSRGraph.h"
+#include "ReachabilityIndex.h"
+#include "TopologicalOrder.h"
+#include "UnionFind.h"
+#include "LabelIndex.h"
+#include "GraphExporter.h"
+#include "GraphStats.h"
+#include "ChangeLog.h"
+#include "Slab.h"
 
 class Node;
 
@@ -11,16 +25,172 @@ class Node;
 
 class Graph {
 private:
+    // indexed by Node id; removed and merged-away nodes leave a NULL slot
     std::vector<Node*> *nodes;
     std::vector<Edge*> *edges;
-    std::map<std::string, Node*> *nodeMap;
+
+    // labels map to the id of the node they were created with. Merging
+    // unites the ids in classes, and leaders holds the id of the live Node
+    // of each class root (INVALID_NODE once that node is removed).
+    LabelIndex *labelIndex;
+    UnionFind *classes;
+    std::vector<NodeId> *leaders;
+
+    // every Node and Edge of the graph is carved out of these pools;
+    // removed nodes and edges return their slots for reuse
+    Slab<Node> *nodePool;
+    Slab<Edge> *edgePool;
+
+    // NULL slots in nodes, and the fraction of all slots at which
+    // removeNode compacts the graph (0 = never)
+    std::size_t deadSlots;
+    double compactThreshold;
+
+    // merges and removeNode calls so far, reported by stats()
+    uint64_t mergeCount;
+    uint64_t removeCount;
+
+    // per-operation counters filled by GRAPH_PROBE when built with
+    // GRAPH_INSTRUMENT. Present either way, so the layout of Graph does
+    // not depend on the flag
+    AtomicOpCounter probes[GRAPH_OP_COUNT];
+
+    // bumped by every mutation made through the Graph; freeze() uses it
+    // to decide whether the cached snapshot is still current
+    unsigned long version;
+    CSRGraph *frozen;
+    unsigned long frozenVersion;
+    CompressedCSRGraph *compressed;
+    unsigned long compressedVersion;
+
+    // built by the first reaches() call, following the edges of the
+    // kinds in reachKinds. It stays valid across a createEdge between
+    // nodes that already reach each other or of a kind it does not
+    // follow, and is rebuilt on the next query after any other mutation
+    // or for another mask. reachIds maps node ids to the ids the index
+    // was built with
+    ReachabilityIndex *reachIndex;
+    std::vector<NodeId> *reachIds;
+    unsigned long reachVersion;
+    EdgeKindMask reachKinds;
+
+    // non-NULL while a topological order is maintained
+    TopologicalOrder *topoOrder;
+
+    // set between beginConcurrent and endConcurrent. nodeLock guards the
+    // node table and nodePool; the table is reserved up to nodeLimit
+    // beforehand, so appending never moves it under other threads
+    bool concurrent;
+    std::mutex nodeLock;
+    std::size_t nodeLimit;
+
+    // while concurrent, the adjacency lists of a node are guarded by the
+    // stripe its id falls in, and the edges it gains come from that
+    // stripe's pool. Allocated on first use and kept with the edges
+    struct alignas(64) Stripe {
+        std::mutex lock;
+        Slab<Edge> edgePool;
+    };
+    static const unsigned STRIPES = 1024;
+    Stripe *stripes;
+
+    // non-NULL while changes are being recorded (see recordChanges)
+    ChangeLog *changeLog;
+
+    // records a change made at the current version, before its bump
+    void logChange(ChangeOp op, NodeId a, NodeId b = INVALID_NODE,
+                   unsigned kind = 0) {
+        if (changeLog != NULL)
+        {
+            changeLog->record(version, op, a, b, kind);
+        }
+    }
+
+    // allocates a Node from the pool, gives it the next free id and
+    // adds it to the graph. Returns NULL when concurrent and the reserved
+    // room is used up
+    Node* newNode(std::string label);
+
+    // destroys a Node that is already detached from its labels
+    void destroyNode(Node* thisNode);
+
+    // with a topological order maintained, moves it so that it fits the
+    // node merge(A, B) is about to make. Returns false if A and B are on
+    // a common path, so the merge closes a cycle
+    bool orderMerge(Node* A, Node* B);
+
+    // joins the id class of B to that of A, led by A. Only for merge(),
+    // which destroys B; a live node must keep resolving to itself
+    void uniteLabels(Node* A, Node* B);
+
+    // body of the bulk builders; kinds, if given, holds one kind per
+    // pair and overrides kind
+    void addEdgeBatch(const std::vector<std::pair<NodeId, NodeId> >& edges,
+                      const std::vector<EdgeKind>* kinds, EdgeKind kind,
+                      unsigned threads);
+
+    // applies one change of a log, as replay() does. Returns false if it
+    // does not fit this graph
+    bool applyChange(const ChangeLog& log, const Change& change);
+
+    // constructor and destructor bodies, shared with operator=
+    void allocate();
+    void release();
+
+    // fills an empty graph with a deep copy of another
+    void copyFrom(const Graph &graph);
+
+    // maps a dominator tree of the frozen view (built by csr) to node
+    // ids, in place
+    void treeById(const CSRGraph* csr, std::vector<NodeId>& tree) const;
+
+    // shared body of dominanceFrontiers and postDominanceFrontiers
+    void frontiersById(const std::vector<NodeId>& tree, bool post,
+                       std::vector<EdgeOffset>& offsets,
+                       std::vector<NodeId>& frontier);
+
+    // gives the live nodes listed in order (old ids, each live node
+    // once) the ids 0, 1, ... in that order, and returns the map
+    // described at compact()
+    std::vector<NodeId> renumber(const std::vector<NodeId>& order);
+
+    // moves every edge into a fresh pool laid out in id order: the
+    // out-edges of node 0 first, then those of node 1, and so on
+    void relocateEdges();
+
+    // id -> id in the slice being extracted by subgraph or neighborhood.
+    // Grown on demand and all INVALID_NODE between calls, so an
+    // extraction costs the size of the slice, not of the graph
+    std::vector<NodeId> *sliceIds;
+
+    // builds the slice whose nodes are listed in members (live, distinct
+    // and already numbered in sliceIds), then resets sliceIds
+    Graph* extract(const std::vector<NodeId>& members,
+                   std::vector<NodeId>* originalIds);
 
 public:
+    // node orders for reorder()
+    enum ReorderStrategy {
+        REORDER_BFS,
+        REORDER_RCM,
+        REORDER_DEGREE
+    };
+
+    // which edges neighborhood() follows
+    enum Direction {
+        OUTGOING,
+        INCOMING,
+        BOTH
+    };
+
     // default constructor. Makes an empty graph
     Graph();
 
-    // copy constructor
+    // copy constructor and assignment. Make a deep copy: the copy has
+    // its own nodes, edges and labels, with the same ids and the same
+    // edge order, and can be changed independently of the original
     Graph(const Graph &graph);
+    Graph& operator=(const Graph &graph);
 
     // destructor
     ~Graph();
@@ -34,8 +204,12 @@ public:
         return edges;
     }
 
-    std::map<std::string, Node*> * getNodeMap() const{
-        return nodeMap;
+    LabelIndex * getLabelIndex() const{
+        return labelIndex;
+    }
+
+    unsigned long getVersion() const{
+        return version;
     }
 
     // to create a new Node without edges and add it to the graph.
@@ -43,21 +217,55 @@ public:
 
     // to create a new Node which is the source.
     // Finds the Node corresponding to the input target label and attaches
-    // the new source Node to it. Node is added to the graph.
-    void makeNode(std::string sourceVar, std::string targetVar);
+    // the new source Node to it. Node is added to the graph. Returns
+    // false, without adding the edge, if the target label is unknown,
+    // if concurrent and the reserved room for nodes is used up, or if
+    // createEdge refused the edge
+    bool makeNode(std::string sourceVar, std::string targetVar,
+                  EdgeKind kind = EDGE_MAY);
 
     // given two variables and the edge type (MAY or MUST), this method
     // will construct two new vertices, construct an edge between them,
-    //and add the  vertices to the graph
-    void makeNodes(std::string sourceVar, std::string targetVar);
+    //and add the  vertices to the graph. Returns false as makeNode does
+    bool makeNodes(std::string sourceVar, std::string targetVar,
+                   EdgeKind kind = EDGE_MAY);
 
     // given labels corresponding to vertices, this method adds an edge
-    // from the source to the target
-    bool createEdge(std::string sourceVar, std::string targetVar);
+    // from the source to the target. Returns false if either label is
+    // unknown or the edge was refused (see below)
+    bool createEdge(std::string sourceVar, std::string targetVar,
+                    EdgeKind kind = EDGE_MAY);
+
+    // given vertices, this method adds an edge of the given kind from
+    // the source to the target. Returns false only if a topological
+    // order is being maintained and the edge would close a cycle; the
+    // edge is then not added. An edge that already exists keeps its kind
+    bool createEdge(Node* sourceNode, Node* targetNode,
+                    EdgeKind kind = EDGE_MAY);
 
-    // given vertices, this method adds an edge from the source
-    // to the target
-    void createEdge(Node* sourceNode, Node* targetNode);
+    // changes the kind of the edge from source to target. Returns false
+    // if there is no such edge
+    bool setEdgeKind(Node* sourceNode, Node* targetNode, EdgeKind kind);
+
+    // bulk ingestion: adds a whole batch of (source, target) edges at once.
+    // Labels are interned as makeNodes would (target first), the batch is
+    // sorted and deduplicated, and adjacency is filled one source (resp.
+    // target) range per thread. The resulting graph has the same nodes
+    // and edges as calling makeNodes for every pair; only the order of
+    // edges within a node's lists may differ. threads == 0 uses all cores.
+    // While a topological order is maintained, edges are added one at a
+    // time through createEdge instead, and those closing a cycle are
+    // dropped. Ids are resolved as by createEdgeById, and pairs with an
+    // end that resolves to INVALID_NODE are skipped. New edges get the
+    // given kind, or with kinds (one per pair) their own; a pair listed
+    // with both kinds gives a may-edge. Edges already there keep theirs
+    void addEdges(const std::vector<std::pair<std::string, std::string> >& edges,
+                  unsigned threads = 0, EdgeKind kind = EDGE_MAY);
+    void addEdgesById(const std::vector<std::pair<NodeId, NodeId> >& edges,
+                      unsigned threads = 0, EdgeKind kind = EDGE_MAY);
+    void addEdgesById(const std::vector<std::pair<NodeId, NodeId> >& edges,
+                      const std::vector<EdgeKind>& kinds,
+                      unsigned threads = 0);
 
     // to remove a Node from the graph. this will delete all edges that
     // include this Node from any other Node, remove this Node from the
@@ -65,37 +273,291 @@ public:
     void removeNode(std::string label);
     void removeNode(Node* thisNode);
 
+    // removes the edge from source to target. Returns false if there is
+    // none. Needs exclusive access
+    bool removeEdge(Node* sourceNode, Node* targetNode);
+
     // given the label of a current Node and a new label, this method
     // constructs a new Node with the same outgoing edges as the old Node.
     // Adds to graph if clong is successful, return true, otherwise false
     bool cloneNode(std::string newLabel, std::string oldLabel);
 
     //private:
-    // given a label, returns the Node which the label corresponds to
-    Node* getNodeAtLabel(std::string label);
+    // given a label, returns the Node which the label corresponds to,
+    // following merges to the node the label's class now lives in
+    Node* getNodeAtLabel(std::string_view label);
+
+    //===-------------------------------------------------------------===//
+    // Id-based access. Every node has a dense NodeId (its slot in
+    // getNodes()), so hot loops can work with integers only. Ids of
+    // removed or merged-away nodes stay allocated and resolve to
+    // INVALID_NODE / NULL.
+
+    // number of ids handed out so far, live or not
+    NodeId numNodeIds() const{
+        return (NodeId) nodes->size();
+    }
+
+    // number of nodes currently in the graph
+    NodeId numLiveNodes() const{
+        return (NodeId) (nodes->size() - deadSlots);
+    }
+
+    // returns the Node with the given id, or NULL if it is gone
+    Node* getNodeById(NodeId id) const{
+        return id < nodes->size() ? (*nodes)[id] : NULL;
+    }
+
+    // given a label, returns the id of the Node it corresponds to,
+    // or INVALID_NODE
+    NodeId getIdAtLabel(std::string_view label);
+
+    // follows merges from any id ever handed out to the id of the live
+    // Node that now holds it, or INVALID_NODE if that Node was removed
+    NodeId resolve(NodeId id);
+
+    // returns the id of the Node for label, creating the Node if needed
+    NodeId internLabel(std::string_view label);
+
+    // adds an edge between the nodes the two ids resolve to (see
+    // resolve(), so an id merged away stands for the node it went into);
+    // false if either resolves to INVALID_NODE or createEdge refused the
+    // edge. addEdgesById treats ids the same way
+    bool createEdgeById(NodeId source, NodeId target,
+                        EdgeKind kind = EDGE_MAY);
+
+    // removes the node with the given id if it is still live
+    void removeNodeById(NodeId id);
+
+    // renumbers the live nodes densely, keeping their relative order, and
+    // drops the NULL slots of removed and merged-away nodes together with
+    // labels that no longer resolve. Returns a map from every id handed
+    // out before to the new id of the node it resolves to, or
+    // INVALID_NODE. Node pointers stay valid; ids do not
+    std::vector<NodeId> compact();
+
+    // renumbers the live nodes so that neighbors get nearby ids, then
+    // lays the edges out in the new order, so walking the nodes by id
+    // (and every view frozen afterwards) touches memory sequentially:
+    //   REORDER_BFS     breadth-first, following edges either way, one
+    //                   connected component after the other
+    //   REORDER_RCM     reverse Cuthill-McKee: breadth-first from a node
+    //                   of least degree, visiting neighbors by increasing
+    //                   degree, and the whole order reversed
+    //   REORDER_DEGREE  by decreasing degree, so the hubs sit together
+    // Empty slots are dropped as by compact(), and the map returned is
+    // the same. Node pointers stay valid; ids and Edge pointers do not
+    std::vector<NodeId> reorder(ReorderStrategy strategy);
+
+    // makes removeNode call compact() as soon as more than the given
+    // fraction of id slots are empty, so pruning a large part of the
+    // graph keeps it dense (0 turns this off, the default). Only useful
+    // to callers that hold Node pointers or labels rather than ids
+    void setCompactThreshold(double fraction) {
+        compactThreshold = fraction;
+    }
+
+    // copies the subgraph induced by the given nodes into a new Graph,
+    // which the caller deletes. Node i of the slice is the i-th distinct
+    // live node listed; originalIds, if given, receives the id each slice
+    // node had here. Nodes keep their own label (labels taken over from
+    // merged nodes stay behind) and edges keep their direction. Edges go
+    // straight into the slice's pools, without per-edge duplicate checks
+    Graph* subgraph(const std::vector<NodeId>& ids,
+                    std::vector<NodeId>* originalIds = NULL);
+    Graph* subgraph(const std::vector<std::string>& labels,
+                    std::vector<NodeId>* originalIds = NULL);
+
+    // same as subgraph() over the nodes at most k edges away from root,
+    // following the given direction. Slice nodes are numbered in BFS
+    // order, so the root becomes node 0. Edges between any two of these
+    // nodes are copied, not just those of the search tree
+    Graph* neighborhood(NodeId root, unsigned k,
+                        Direction direction = OUTGOING,
+                        std::vector<NodeId>* originalIds = NULL);
+
+    //===-------------------------------------------------------------===//
+    // Concurrent mutation. Between beginConcurrent and endConcurrent any
+    // number of threads may call makeNode, makeNodes, createEdge,
+    // createEdgeById, internLabel, getNodeAtLabel, getIdAtLabel and
+    // resolve on the same graph at once. Labels go through a sharded
+    // LabelIndex, and an edge locks only the stripes of its two nodes.
+    // The graph ends up with the same nodes, labels and edges as if the
+    // calls had been made one after another; only node ids and the order
+    // of edges within a node's lists depend on the scheduling. Nothing
+    // else (getNodeById and numNodeIds included) may run until
+    // endConcurrent returns.
+    //
+    // maxNewNodes bounds the nodes created in between: the node table is
+    // reserved up front, and once the room is used up makeNode returns
+    // NULL and internLabel INVALID_NODE. Ids passed to createEdgeById
+    // and resolve must have been handed out by this graph
+    void beginConcurrent(std::size_t maxNewNodes, unsigned shards = 64);
+    void endConcurrent();
+
+    bool isConcurrent() const{
+        return concurrent;
+    }
 
     // given another Node, this method copies every edge outgoing from
-    // the other Node and adds to this one
-    void addTargetsOfOther(Node* thisNode, Node* otherNode);
+    // the other Node whose kind is in the mask, with its kind, and adds
+    // to this one
+    void addTargetsOfOther(Node* thisNode, Node* otherNode,
+                           EdgeKindMask kinds = ALL_EDGE_KINDS);
 
     // given another Node, this method copies every edge incoming from
-    // the other Node and adds to this one
-    void addSourcesOfOther(Node* thisNode, Node* otherNode);
+    // the other Node whose kind is in the mask and adds to this one
+    void addSourcesOfOther(Node* thisNode, Node* otherNode,
+                           EdgeKindMask kinds = ALL_EDGE_KINDS);
+
+    // given a source Node and a target Node, this method merges the
+    // target into the (at most one) child of the source.
+    // return true if a merge happened, and false if no merge occurred
+    bool unionize(Node* source, Node* target);
 
     // given vertices A and B, this method merges Node B into Node A.
+    // A maintained topological order is kept unless A and B are on a
+    // common path, in which case the merge closes a cycle and stops
+    // topological order upkeep (see maintainTopologicalOrder).
     // Node A will now have all incoming and outgoing edges that B had.
-    // B is removed from the graph.
+    // B is removed from the graph. Runs in time proportional to the
+    // degrees of A and B, independent of the size of the graph.
     void merge(Node* A, Node* B);
 
     // given vertixes A and B, this method takes all the labels from B and
-    // adds them to the list of A's labels.
-    // it also updates the NodeMap with this new information
+    // adds them to the list of A's labels, including labels of nodes that
+    // were merged into B earlier. B stays in the graph under its own id
+    // (resolve() still maps it to itself) but no label leads to it any
+    // more. Costs one pass over the labels; merge() instead joins the id
+    // classes, which is near-constant time.
     void takeLabels(Node* A, Node* B);
 
-    // creates a dot file of the graph for visual inspection
-    void createDotFile(std::string fileName);
+    // starts keeping a topological order up to date: from then on
+    // createEdge refuses edges that would close a cycle and reorders
+    // only the affected region (see TopologicalOrder). Returns false,
+    // and keeps nothing, if the graph already has a cycle. Self-loops
+    // count as cycles. The order survives merge() unless the two nodes
+    // are on a common path; such a merge, and beginConcurrent, drop it,
+    // which hasTopologicalOrder() reports
+    bool maintainTopologicalOrder();
+    void dropTopologicalOrder();
+
+    bool hasTopologicalOrder() const{
+        return topoOrder != NULL;
+    }
+
+    // the live node ids in the maintained order (empty if none)
+    std::vector<NodeId> topologicalOrder() const;
+
+    // returns an immutable compressed-sparse-row view of the graph.
+    // The view is cached and rebuilt on the next call after the graph
+    // changes, which invalidates the previously returned pointer.
+    const CSRGraph* freeze();
+
+    // same as freeze(), but returns a view with varint-compressed
+    // neighbor lists (see CompressedCSRGraph), built on several threads
+    // (0 = all cores) straight from the nodes. The two views are cached
+    // independently and use the same ids
+    const CompressedCSRGraph* freezeCompressed(unsigned threads = 0);
+
+    // finds the strongly connected components of the graph without
+    // recursion. component is indexed by node id (INVALID_NODE for empty
+    // slots). threads == 1 runs Tarjan, numbering components in reverse
+    // topological order; otherwise the parallel forward-backward search
+    // is used (0 = all cores). Returns the number of components
+    NodeId findSCCs(std::vector<NodeId>& component, unsigned threads = 1);
+
+    // collapses every strongly connected component into one node with
+    // merge(), so the graph becomes its condensation DAG. Edges inside a
+    // component become a self-loop on its node, as with merge(). Returns
+    // the number of nodes merged away
+    std::size_t condense(unsigned threads = 1);
+
+    // returns true if there is a path from one node to the other along
+    // edges of the kinds in the mask (every node reaches itself).
+    // Queries go through a ReachabilityIndex that is built on first use
+    // and kept while the graph and the mask do not change, so repeated
+    // queries cost a bit test or a label comparison
+    bool reaches(Node* from, Node* to, EdgeKindMask kinds = ALL_EDGE_KINDS);
+    bool reaches(NodeId from, NodeId to, EdgeKindMask kinds = ALL_EDGE_KINDS);
+
+    // multi-source reachability over the frozen view, on several threads
+    // (0 = all cores; see BFS.h), following the edges of the kinds in
+    // the mask. Roots and results use node ids: visited gets bit id % 64
+    // of word id / 64 set for every node reachable from a root, distance
+    // the BFS level of each node or INVALID_NODE
+    void reachable(const std::vector<NodeId>& roots,
+                   std::vector<uint64_t>& visited, unsigned threads = 0,
+                   EdgeKindMask kinds = ALL_EDGE_KINDS);
+    void distances(const std::vector<NodeId>& roots,
+                   std::vector<NodeId>& distance, unsigned threads = 0,
+                   EdgeKindMask kinds = ALL_EDGE_KINDS);
+
+    // immediate dominators of the nodes reachable from entry, over the
+    // frozen view (Lengauer-Tarjan, see Dominators.h). idom is indexed by
+    // node id: the entry maps to itself, unreachable nodes and empty
+    // slots to INVALID_NODE. postDominators does the same along in-edges,
+    // from exit
+    void dominators(NodeId entry, std::vector<NodeId>& idom);
+    void postDominators(NodeId exit, std::vector<NodeId>& ipdom);
+
+    // frontiers of a tree computed above, by node id: the frontier of id
+    // is frontier[offsets[id]] .. frontier[offsets[id + 1] - 1], in
+    // ascending order
+    void dominanceFrontiers(const std::vector<NodeId>& idom,
+                            std::vector<EdgeOffset>& offsets,
+                            std::vector<NodeId>& frontier);
+    void postDominanceFrontiers(const std::vector<NodeId>& ipdom,
+                                std::vector<EdgeOffset>& offsets,
+                                std::vector<NodeId>& frontier);
 
-    // print functions
+    // writes the current graph (via freeze()) to a binary snapshot file,
+    // keeping every label that still resolves to a live node. Returns
+    // false if the file could not be written. CSRGraph::load maps such
+    // a file read-only without rebuilding anything
+    bool save(const std::string& path);
+
+    // adds the nodes, labels and edges of a snapshot file to this graph
+    // (labels already present are reused, as with makeNode, and edges
+    // already present keep their kind). Returns false if the file is
+    // missing or not a valid snapshot
+    bool load(const std::string& path);
+
+    // creates a dot file of the graph for visual inspection. options can
+    // cap the edge count, filter nodes, cluster SCCs and format on several
+    // threads. Returns false if the file could not be written
+    bool createDotFile(std::string fileName);
+    bool createDotFile(std::string fileName, const ExportOptions& options);
+
+    // counts, degree histograms, memory footprint and mutation counts of
+    // the graph, plus the probe counters when built with
+    // GRAPH_INSTRUMENT (see GraphStats.h). topNodes lists the topCount
+    // nodes with the most edges. One pass over the nodes; not while
+    // concurrent
+    GraphStats stats(std::size_t topCount = 16) const;
+
+    // starts (true) or stops (false) recording every mutation made
+    // through the graph in a ChangeLog; stopping drops the log. Copies of
+    // the graph do not record
+    void recordChanges(bool on);
+
+    // the log being recorded, or NULL
+    const ChangeLog* changes() const{
+        return changeLog;
+    }
+
+    // applies the changes of a log from position first on to this graph,
+    // which must be in the state the logged graph was in just before that
+    // change: a copy taken then, or a graph loaded from a snapshot saved
+    // then, provided the saved graph had no empty id slots (compact() it
+    // first). Auto-compaction stays off meanwhile, since renumberings are
+    // in the log. Returns false, after applying the changes before it, at
+    // the first change that does not fit
+    bool replay(const ChangeLog& log, std::size_t first = 0);
+
+    // print functions (to stderr)
     void printAllNodes();
     void printGraph();
 };
+
+#endif
@@ -0,0 +1,308 @@
+/*
+* GraphExporter.cpp
+*/
+#include "GraphExporter.h"
+#include "Parallel.h"
+#include "SCC.h"
+
+#include <cstring>
+
+//===-----------------------------------------------------------------===//
+//////////////////////////  GraphExporter Class  //////////////////////////
+//===-----------------------------------------------------------------===//
+
+static const char DOT_HEADER[] =
+    "digraph {\n"
+    "ordering=out;\nranksep=.3;\n  bgcolor=\"#292929\"; \
+                            node [shape=box, fixedsize=false,\
+                            fontsize=10, \
+                            fontname=\"Courier-Bold\",\
+                            fontcolor=\"grey4\"\n"
+    "width=.15, height=.15, color=\"#00C389\",\
+                            fillcolor=\"#00C389\",\
+                            style=\"filled, solid, solid\"];\n"
+    "edge [arrowsize=.4, color=\"firebrick1\",\
+                        style=\"solid\"];\n";
+
+// rough size of one formatted edge line, used to size parallel chunks
+static const std::size_t BYTES_PER_EDGE = 32;
+
+GraphExporter::GraphExporter(const CSRGraph& graph, const ExportOptions& options)
+    : graph(graph), options(options)
+{
+    if (this->options.threads == 0)
+    {
+        this->options.threads = hardwareThreads();
+    }
+    if (this->options.bufferSize == 0)
+    {
+        this->options.bufferSize = 1 << 20;
+    }
+}
+
+// evaluates the node filter once per node, so edges only test a byte
+void
+GraphExporter::prepare()
+{
+    if (options.nodeFilter && keep.empty())
+    {
+        keep.resize(graph.numNodes());
+        for (NodeId v = 0; v < graph.numNodes(); v++)
+        {
+            keep[v] = options.nodeFilter(v, graph.label(v)) ? 1 : 0;
+        }
+    }
+}
+
+// quotes a label, escaping the characters DOT would otherwise choke on
+static void
+appendLabel(std::string& out, std::string_view label, bool escape)
+{
+    out.push_back('"');
+    if (escape && label.find_first_of("\"\\") != std::string_view::npos)
+    {
+        for (std::size_t i = 0; i < label.size(); i++)
+        {
+            if (label[i] == '"' || label[i] == '\\')
+            {
+                out.push_back('\\');
+            }
+            out.push_back(label[i]);
+        }
+    }
+    else
+    {
+        out.append(label.data(), label.size());
+    }
+    out.push_back('"');
+}
+
+static bool
+flush(FILE* out, std::string& buffer)
+{
+    bool ok = buffer.empty()
+        || fwrite(buffer.data(), 1, buffer.size(), out) == buffer.size();
+    buffer.clear();
+    return ok;
+}
+
+EdgeOffset
+GraphExporter::formatEdges(NodeId first, NodeId last, EdgeOffset limit,
+                           bool dot, std::string& out) const
+{
+    EdgeOffset written = 0;
+    for (NodeId v = first; v < last; v++)
+    {
+        if (!kept(v))
+        {
+            continue;
+        }
+        CSRGraph::NeighborRange targets = graph.outNeighbors(v);
+        for (std::size_t i = 0; i < targets.size(); i++)
+        {
+            if (!kept(targets[i]))
+            {
+                continue;
+            }
+            if (written == limit)
+            {
+                return written;
+            }
+            appendLabel(out, graph.label(v), dot);
+            out.append(" -> ", 4);
+            appendLabel(out, graph.label(targets[i]), dot);
+            out.push_back('\n');
+            written++;
+        }
+    }
+    return written;
+}
+
+bool
+GraphExporter::writeEdges(FILE* out, bool dot)
+{
+    NodeId n = graph.numNodes();
+    EdgeOffset remaining = options.maxEdges == 0 ? (EdgeOffset) -1
+                                                 : options.maxEdges;
+    bool ok = true;
+
+    if (options.threads == 1)
+    {
+        std::string buffer;
+        buffer.reserve(options.bufferSize + 4096);
+        for (NodeId v = 0; v < n && remaining > 0; v++)
+        {
+            remaining -= formatEdges(v, v + 1, remaining, dot, buffer);
+            if (buffer.size() >= options.bufferSize)
+            {
+                ok = flush(out, buffer) && ok;
+            }
+        }
+        return flush(out, buffer) && ok;
+    }
+
+    // cut the nodes into chunks of about one buffer of output each
+    std::size_t chunkEdges = options.bufferSize / BYTES_PER_EDGE + 1;
+    std::vector<NodeId> cuts(1, 0);
+    std::size_t pending = 0;
+    for (NodeId v = 0; v < n; v++)
+    {
+        pending += graph.outDegree(v);
+        if (pending >= chunkEdges)
+        {
+            cuts.push_back(v + 1);
+            pending = 0;
+        }
+    }
+    if (cuts.back() != n)
+    {
+        cuts.push_back(n);
+    }
+
+    // one wave formats `threads` chunks side by side, then writes them in
+    // order; the buffers are reused from wave to wave
+    unsigned threads = options.threads;
+    std::vector<std::string> buffers(threads);
+    std::vector<EdgeOffset> counts(threads);
+    for (std::size_t c = 0; c + 1 < cuts.size() && remaining > 0; c += threads)
+    {
+        std::size_t wave = std::min<std::size_t>(threads, cuts.size() - 1 - c);
+        parallelFor(0, wave, threads,
+            [&](std::size_t lo, std::size_t hi, unsigned)
+            {
+                for (std::size_t k = lo; k < hi; k++)
+                {
+                    buffers[k].clear();
+                    counts[k] = formatEdges(cuts[c + k], cuts[c + k + 1],
+                                            remaining, dot, buffers[k]);
+                }
+            });
+
+        for (std::size_t k = 0; k < wave && remaining > 0; k++)
+        {
+            if (counts[k] > remaining)
+            {
+                // the edge limit falls inside this chunk
+                buffers[k].clear();
+                counts[k] = formatEdges(cuts[c + k], cuts[c + k + 1],
+                                        remaining, dot, buffers[k]);
+            }
+            remaining -= counts[k];
+            ok = flush(out, buffers[k]) && ok;
+        }
+    }
+    return ok;
+}
+
+// one cluster per component of two or more kept nodes
+bool
+GraphExporter::writeClusters(FILE* out)
+{
+    NodeId n = graph.numNodes();
+    NodeId count = findSCCs(graph, component);
+
+    // group the members of each component, counting sort by component
+    std::vector<NodeId> start(count + 1, 0);
+    NodeId v;
+    for (v = 0; v < n; v++)
+    {
+        if (kept(v))
+        {
+            start[component[v] + 1]++;
+        }
+    }
+    for (NodeId c = 0; c < count; c++)
+    {
+        start[c + 1] += start[c];
+    }
+    std::vector<NodeId> members(start[count]);
+    std::vector<NodeId> fill(start.begin(), start.end() - 1);
+    for (v = 0; v < n; v++)
+    {
+        if (kept(v))
+        {
+            members[fill[component[v]]++] = v;
+        }
+    }
+
+    std::string buffer;
+    bool ok = true;
+    char header[48];
+    for (NodeId c = 0; c < count; c++)
+    {
+        if (start[c + 1] - start[c] < 2)
+        {
+            continue;
+        }
+        int length = snprintf(header, sizeof(header), "subgraph cluster_%u {\n", c);
+        buffer.append(header, length);
+        for (NodeId m = start[c]; m < start[c + 1]; m++)
+        {
+            appendLabel(buffer, graph.label(members[m]), true);
+            buffer.append(";\n", 2);
+        }
+        buffer.append("}\n", 2);
+        if (buffer.size() >= options.bufferSize)
+        {
+            ok = flush(out, buffer) && ok;
+        }
+    }
+    return flush(out, buffer) && ok;
+}
+
+bool
+GraphExporter::writeDot(const std::string& fileName)
+{
+    FILE* out = fopen(fileName.c_str(), "w");
+    if (out == NULL)
+    {
+        return false;
+    }
+    bool ok = writeDot(out);
+    return (fclose(out) == 0) && ok;
+}
+
+bool
+GraphExporter::writeDot(FILE* out)
+{
+    prepare();
+    bool ok = fputs(DOT_HEADER, out) >= 0;
+    if (options.clusterBySCC)
+    {
+        ok = writeClusters(out) && ok;
+    }
+    ok = writeEdges(out, true) && ok;
+    ok = fputs("}\n", out) >= 0 && ok;
+    return fflush(out) == 0 && ok;
+}
+
+bool
+GraphExporter::writeEdgeList(FILE* out)
+{
+    prepare();
+    bool ok = writeEdges(out, false);
+    return fflush(out) == 0 && ok;
+}
+
+bool
+GraphExporter::writeNodeList(FILE* out)
+{
+    prepare();
+    std::string buffer;
+    bool ok = true;
+    for (NodeId v = 0; v < graph.numNodes(); v++)
+    {
+        if (kept(v))
+        {
+            std::string_view label = graph.label(v);
+            buffer.append(label.data(), label.size());
+            buffer.push_back('\n');
+            if (buffer.size() >= options.bufferSize)
+            {
+                ok = flush(out, buffer) && ok;
+            }
+        }
+    }
+    ok = flush(out, buffer) && ok;
+    return fflush(out) == 0 && ok;
+}
@@ -0,0 +1,84 @@
+/*
+* GraphExporter.h
+*/
+#ifndef GRAPHEXPORTER_H_
+#define GRAPHEXPORTER_H_
+
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "CSRGraph.h"
+
+// options for exporting a large graph
+struct ExportOptions {
+    // stop after this many edges; 0 means no limit
+    EdgeOffset maxEdges;
+
+    // when set, only nodes for which it returns true are written, along
+    // with the edges between them
+    std::function<bool(NodeId, std::string_view)> nodeFilter;
+
+    // wrap every strongly connected component of more than one node in
+    // its own DOT cluster
+    bool clusterBySCC;
+
+    // threads formatting node ranges; 1 is serial, 0 uses all cores
+    unsigned threads;
+
+    // bytes collected before a write is issued
+    std::size_t bufferSize;
+
+    ExportOptions()
+        : maxEdges(0), clusterBySCC(false), threads(1),
+          bufferSize(1 << 20) {}
+};
+
+/////////////////    GraphExporter Class   //////////////////////
+
+// Streams a frozen graph out as DOT or as a plain edge/node list. Output
+// is formatted straight into large reusable buffers (no per-edge strings
+// or stream flushes). In parallel mode the node range is cut into chunks
+// that threads format independently; chunks are written in order, so
+// the output is byte-for-byte the same as the serial one.
+class GraphExporter {
+    private:
+        const CSRGraph& graph;
+        ExportOptions options;
+
+        // nodes that pass the filter (empty when there is no filter)
+        std::vector<char> keep;
+
+        // per-node component and members of each clustered component
+        std::vector<NodeId> component;
+
+        void prepare();
+        bool kept(NodeId v) const {
+            return keep.empty() || keep[v];
+        }
+
+        // formats the edges of nodes [first, last) into out, stopping
+        // after at most limit edges; returns the number of edges written
+        EdgeOffset formatEdges(NodeId first, NodeId last, EdgeOffset limit,
+                               bool dot, std::string& out) const;
+
+        bool writeEdges(FILE* out, bool dot);
+        bool writeClusters(FILE* out);
+
+    public:
+        GraphExporter(const CSRGraph& graph,
+                      const ExportOptions& options = ExportOptions());
+
+        // writes the graph as a DOT digraph
+        bool writeDot(const std::string& fileName);
+        bool writeDot(FILE* out);
+
+        // writes one "\"source\" -> \"target\"" line per edge
+        bool writeEdgeList(FILE* out);
+
+        // writes one label per line
+        bool writeNodeList(FILE* out);
+};
+
+#endif
@@ -0,0 +1,210 @@
+/*
+* GraphStats.cpp
+*/
+#include "GraphStats.h"
+#include <cstdio>
+
+//===-----------------------------------------------------------------===//
+///////////////////////////  GraphStats Class  ////////////////////////////
+//===-----------------------------------------------------------------===//
+
+GraphStats::GraphStats()
+    : nodes(0), idSlots(0), edges(0), labels(0), maxOutDegree(0),
+      maxInDegree(0), nodeBytes(0), edgeBytes(0), adjacencyBytes(0),
+      labelBytes(0), idBytes(0), cacheBytes(0), logBytes(0), merges(0),
+      removals(0),
+#ifdef GRAPH_INSTRUMENT
+      instrumented(true)
+#else
+      instrumented(false)
+#endif
+{
+}
+
+const char*
+graphOpName(GraphOp op)
+{
+    switch (op)
+    {
+        case OP_CREATE_EDGE:
+            return "createEdge";
+        case OP_MERGE:
+            return "merge";
+        case OP_REMOVE_NODE:
+            return "removeNode";
+        case OP_GET_NODE_AT_LABEL:
+            return "getNodeAtLabel";
+        default:
+            return "unknown";
+    }
+}
+
+void
+addToHistogram(std::vector<std::size_t>& histogram, std::size_t value)
+{
+    std::size_t bucket = 0;
+    while (value > 0)
+    {
+        bucket++;
+        value >>= 1;
+    }
+    if (bucket >= histogram.size())
+    {
+        histogram.resize(bucket + 1, 0);
+    }
+    histogram[bucket]++;
+}
+
+// appends a formatted number
+static void
+appendNumber(std::string& out, uint64_t value)
+{
+    char buffer[24];
+    int length = std::snprintf(buffer, sizeof(buffer), "%llu",
+                               (unsigned long long) value);
+    out.append(buffer, length);
+}
+
+static void
+appendField(std::string& out, const char* name, uint64_t value)
+{
+    out += '"';
+    out += name;
+    out += "\": ";
+    appendNumber(out, value);
+}
+
+static void
+appendArray(std::string& out, const std::vector<std::size_t>& values)
+{
+    out += '[';
+    for (std::size_t i = 0; i < values.size(); i++)
+    {
+        if (i > 0)
+        {
+            out += ", ";
+        }
+        appendNumber(out, values[i]);
+    }
+    out += ']';
+}
+
+// appends s as a JSON string literal; labels may hold anything
+static void
+appendString(std::string& out, const std::string& s)
+{
+    out += '"';
+    for (std::size_t i = 0; i < s.size(); i++)
+    {
+        unsigned char c = (unsigned char) s[i];
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+            out += (char) c;
+        }
+        else if (c < 0x20)
+        {
+            char buffer[8];
+            std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+            out += buffer;
+        }
+        else
+        {
+            out += (char) c;
+        }
+    }
+    out += '"';
+}
+
+std::string
+GraphStats::toJSON() const
+{
+    std::string out = "{\n  ";
+    appendField(out, "nodes", nodes);
+    out += ",\n  ";
+    appendField(out, "idSlots", idSlots);
+    out += ",\n  ";
+    appendField(out, "edges", edges);
+    out += ",\n  ";
+    appendField(out, "labels", labels);
+    out += ",\n  ";
+    appendField(out, "merges", merges);
+    out += ",\n  ";
+    appendField(out, "removals", removals);
+
+    out += ",\n  \"degrees\": {\n    ";
+    appendField(out, "maxOut", maxOutDegree);
+    out += ",\n    ";
+    appendField(out, "maxIn", maxInDegree);
+    out += ",\n    \"outHistogram\": ";
+    appendArray(out, outDegrees);
+    out += ",\n    \"inHistogram\": ";
+    appendArray(out, inDegrees);
+    out += "\n  }";
+
+    out += ",\n  \"topNodes\": [";
+    for (std::size_t i = 0; i < topNodes.size(); i++)
+    {
+        out += i > 0 ? ",\n    {" : "\n    {";
+        appendField(out, "id", topNodes[i].id);
+        out += ", \"label\": ";
+        appendString(out, topNodes[i].label);
+        out += ", ";
+        appendField(out, "out", topNodes[i].outDegree);
+        out += ", ";
+        appendField(out, "in", topNodes[i].inDegree);
+        out += '}';
+    }
+    out += topNodes.empty() ? "]" : "\n  ]";
+
+    out += ",\n  \"bytes\": {\n    ";
+    appendField(out, "nodes", nodeBytes);
+    out += ",\n    ";
+    appendField(out, "edges", edgeBytes);
+    out += ",\n    ";
+    appendField(out, "adjacency", adjacencyBytes);
+    out += ",\n    ";
+    appendField(out, "labels", labelBytes);
+    out += ",\n    ";
+    appendField(out, "ids", idBytes);
+    out += ",\n    ";
+    appendField(out, "caches", cacheBytes);
+    out += ",\n    ";
+    appendField(out, "log", logBytes);
+    out += ",\n    ";
+    appendField(out, "total", totalBytes());
+    out += "\n  }";
+
+    out += ",\n  \"instrumented\": ";
+    out += instrumented ? "true" : "false";
+    if (instrumented)
+    {
+        out += ",\n  \"operations\": {";
+        for (int op = 0; op < GRAPH_OP_COUNT; op++)
+        {
+            out += op > 0 ? ",\n    \"" : "\n    \"";
+            out += graphOpName((GraphOp) op);
+            out += "\": {";
+            appendField(out, "calls", ops[op].calls);
+            out += ", ";
+            appendField(out, "nanoseconds", ops[op].nanoseconds);
+            out += '}';
+        }
+        out += "\n  }";
+    }
+    out += "\n}\n";
+    return out;
+}
+
+bool
+GraphStats::writeJSON(const std::string& path) const
+{
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (file == NULL)
+    {
+        return false;
+    }
+    std::string json = toJSON();
+    bool ok = std::fwrite(json.data(), 1, json.size(), file) == json.size();
+    return std::fclose(file) == 0 && ok;
+}
@@ -0,0 +1,140 @@
+/*
+* GraphStats.h
+*/
+#ifndef GRAPHSTATS_H_
+#define GRAPHSTATS_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "GraphTypes.h"
+
+// Graph operations that can be probed. Build with -DGRAPH_INSTRUMENT to
+// have Graph count the calls of each and the wall time spent in them;
+// otherwise the probes compile to nothing and cost nothing.
+enum GraphOp {
+    OP_CREATE_EDGE,
+    OP_MERGE,
+    OP_REMOVE_NODE,
+    OP_GET_NODE_AT_LABEL,
+    GRAPH_OP_COUNT
+};
+
+// call count and total time of one operation
+struct OpCounter {
+    uint64_t calls;
+    uint64_t nanoseconds;
+
+    OpCounter() : calls(0), nanoseconds(0) {}
+};
+
+// a node with one of the highest degrees in the graph
+struct DegreeEntry {
+    NodeId id;
+    std::string label;
+    std::size_t outDegree;
+    std::size_t inDegree;
+};
+
+// Shape, footprint and activity of a Graph, as returned by
+// Graph::stats(). Degree histograms are logarithmic: bucket 0 counts
+// the nodes of degree 0, bucket b > 0 those of degree 2^(b-1) up to
+// 2^b - 1.
+struct GraphStats {
+    std::size_t nodes;          // live nodes
+    std::size_t idSlots;        // ids handed out, empty slots included
+    std::size_t edges;
+    std::size_t labels;
+
+    std::vector<std::size_t> outDegrees;
+    std::vector<std::size_t> inDegrees;
+    std::size_t maxOutDegree;
+    std::size_t maxInDegree;
+
+    // the nodes with the most edges (in plus out), highest first
+    std::vector<DegreeEntry> topNodes;
+
+    // bytes held by the node and edge pools, the edge lists (with the
+    // per-node target indexes), the label index, the id tables
+    // (node table, union-find, leaders), the cached frozen views and
+    // the change log
+    std::size_t nodeBytes;
+    std::size_t edgeBytes;
+    std::size_t adjacencyBytes;
+    std::size_t labelBytes;
+    std::size_t idBytes;
+    std::size_t cacheBytes;
+    std::size_t logBytes;
+
+    // merges and removeNode calls over the graph's lifetime
+    uint64_t merges;
+    uint64_t removals;
+
+    // true if built with GRAPH_INSTRUMENT; ops is all zero otherwise
+    bool instrumented;
+    OpCounter ops[GRAPH_OP_COUNT];
+
+    GraphStats();
+
+    std::size_t totalBytes() const {
+        return nodeBytes + edgeBytes + adjacencyBytes + labelBytes
+             + idBytes + cacheBytes + logBytes;
+    }
+
+    // the stats as one JSON object
+    std::string toJSON() const;
+
+    // writes toJSON() to a file. Returns false if it could not be written
+    bool writeJSON(const std::string& path) const;
+};
+
+// name of an operation as it appears in the JSON output
+const char* graphOpName(GraphOp op);
+
+// adds a value to a logarithmic histogram as laid out in GraphStats
+void addToHistogram(std::vector<std::size_t>& histogram, std::size_t value);
+
+// counter shared by the threads calling one probed operation
+struct AtomicOpCounter {
+    std::atomic<uint64_t> calls;
+    std::atomic<uint64_t> nanoseconds;
+
+    AtomicOpCounter() : calls(0), nanoseconds(0) {}
+};
+
+#ifdef GRAPH_INSTRUMENT
+
+// counts one call of an operation and the time until the end of the
+// scope it is declared in
+class OpProbe {
+    private:
+        AtomicOpCounter& counter;
+        std::chrono::steady_clock::time_point start;
+
+        OpProbe(const OpProbe&);
+        OpProbe& operator=(const OpProbe&);
+
+    public:
+        explicit OpProbe(AtomicOpCounter& counter)
+            : counter(counter), start(std::chrono::steady_clock::now()) {}
+
+        ~OpProbe() {
+            uint64_t elapsed = std::chrono::duration_cast<
+                std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+            counter.calls.fetch_add(1, std::memory_order_relaxed);
+            counter.nanoseconds.fetch_add(elapsed, std::memory_order_relaxed);
+        }
+};
+
+#define GRAPH_PROBE(counters, op) OpProbe graphProbe_((counters)[op])
+
+#else
+
+#define GRAPH_PROBE(counters, op) ((void) 0)
+
+#endif
+
+#endif
@@ -0,0 +1,30 @@
+/*
+* GraphTypes.h
+*/
+#ifndef GRAPHTYPES_H_
+#define GRAPHTYPES_H_
+
+#include <stdint.h>
+
+// dense integer id of a node: its slot in a Graph, or its position in a
+// compact (frozen) graph
+typedef uint32_t NodeId;
+
+// index into a compact edge array
+typedef uint64_t EdgeOffset;
+
+// sentinel for "no node"
+const NodeId INVALID_NODE = 0xFFFFFFFFu;
+
+// kind of an edge: a may-edge holds on some executions, a must-edge on
+// all of them. Every kind is one bit, so a set of kinds is a mask
+enum EdgeKind {
+    EDGE_MAY = 1,
+    EDGE_MUST = 2
+};
+
+typedef unsigned EdgeKindMask;
+
+const EdgeKindMask ALL_EDGE_KINDS = EDGE_MAY | EDGE_MUST;
+
+#endif
@@ -0,0 +1,129 @@
+/*
+* KindFilter.h
+*/
+#ifndef KINDFILTER_H_
+#define KINDFILTER_H_
+
+#include "GraphTypes.h"
+
+/////////////////    KindFilter Class   //////////////////////
+
+// View of a frozen graph (CSRGraph or CompressedCSRGraph) that only has
+// the edges whose kind is in a mask. Neighbor lists are walked together
+// with the kinds stored beside them and the other edges are skipped on
+// the way, so nothing is copied or looked up. BFS, SCC and
+// ReachabilityIndex accept a filtered view wherever they accept the
+// graph itself.
+//
+// numEdges and the degrees are those of the whole graph: upper bounds,
+// which is all the heuristics that read them need.
+template <class G>
+class KindFilter {
+    public:
+        class NeighborRange {
+            public:
+                typedef typename G::NeighborRange Base;
+
+                class const_iterator {
+                    private:
+                        typename Base::const_iterator at;
+                        typename Base::const_iterator last;
+                        typename Base::KindCursor kind;
+                        EdgeKindMask kinds;
+
+                        void skip() {
+                            while (at != last && !(*kind & kinds))
+                            {
+                                ++at;
+                                ++kind;
+                            }
+                        }
+
+                    public:
+                        const_iterator() : at(), last(), kind(), kinds(0) {}
+                        const_iterator(typename Base::const_iterator at,
+                                       typename Base::const_iterator last,
+                                       typename Base::KindCursor kind,
+                                       EdgeKindMask kinds)
+                            : at(at), last(last), kind(kind), kinds(kinds) {
+                            skip();
+                        }
+
+                        NodeId operator*() const { return *at; }
+
+                        const_iterator& operator++() {
+                            ++at;
+                            ++kind;
+                            skip();
+                            return *this;
+                        }
+
+                        // only meaningful between iterators of one list
+                        bool operator==(const const_iterator& other) const {
+                            return at == other.at;
+                        }
+                        bool operator!=(const const_iterator& other) const {
+                            return at != other.at;
+                        }
+                };
+
+            private:
+                Base base;
+                EdgeKindMask kinds;
+
+            public:
+                NeighborRange(const Base& base, EdgeKindMask kinds)
+                    : base(base), kinds(kinds) {}
+
+                const_iterator begin() const {
+                    return const_iterator(base.begin(), base.end(),
+                                          base.kinds(), kinds);
+                }
+                const_iterator end() const {
+                    return const_iterator(base.end(), base.end(),
+                                          base.kinds(), kinds);
+                }
+        };
+
+    private:
+        const G& graph;
+        EdgeKindMask kinds;
+
+    public:
+        KindFilter(const G& graph, EdgeKindMask kinds)
+            : graph(graph), kinds(kinds) {}
+
+        const G& unfiltered() const {
+            return graph;
+        }
+
+        EdgeKindMask mask() const {
+            return kinds;
+        }
+
+        NodeId numNodes() const {
+            return graph.numNodes();
+        }
+
+        EdgeOffset numEdges() const {
+            return graph.numEdges();
+        }
+
+        NeighborRange outNeighbors(NodeId v) const {
+            return NeighborRange(graph.outNeighbors(v), kinds);
+        }
+
+        NeighborRange inNeighbors(NodeId v) const {
+            return NeighborRange(graph.inNeighbors(v), kinds);
+        }
+
+        std::size_t outDegree(NodeId v) const {
+            return graph.outDegree(v);
+        }
+
+        std::size_t inDegree(NodeId v) const {
+            return graph.inDegree(v);
+        }
+};
+
+#endif
@@ -0,0 +1,180 @@
+/*
+* LabelIndex.cpp
+*/
+#include "LabelIndex.h"
+#include <cstring>
+
+//===-----------------------------------------------------------------===//
+///////////////////////////  LabelIndex Class  ////////////////////////////
+//===-----------------------------------------------------------------===//
+
+LabelIndex::LabelIndex() : shards(new Shard[1]), shardCount(1), locking(false)
+{
+}
+
+LabelIndex::~LabelIndex()
+{
+    clear();
+    delete [] shards;
+}
+
+void
+LabelIndex::Shard::clear()
+{
+    index.clear();
+    for (std::size_t i = 0; i < chunks.size(); i++)
+    {
+        delete [] chunks[i];
+    }
+    chunks.clear();
+    chunkUsed = CHUNK_SIZE;
+    poolBytes = 0;
+}
+
+void
+LabelIndex::clear()
+{
+    for (unsigned s = 0; s < shardCount; s++)
+    {
+        shards[s].clear();
+    }
+}
+
+std::string_view
+LabelIndex::Shard::intern(std::string_view label)
+{
+    std::size_t length = label.size();
+    if (length == 0)
+    {
+        // there may be no chunk yet to point into
+        return std::string_view();
+    }
+    char* copy;
+    if (length > CHUNK_SIZE / 4)
+    {
+        // oversized labels get a chunk of their own; keep the current
+        // chunk last so it goes on filling up
+        copy = new char[length];
+        chunks.insert(chunks.end() - (chunks.empty() ? 0 : 1), copy);
+        poolBytes += length;
+    }
+    else
+    {
+        if (chunkUsed + length > CHUNK_SIZE)
+        {
+            chunks.push_back(new char[CHUNK_SIZE]);
+            chunkUsed = 0;
+            poolBytes += CHUNK_SIZE;
+        }
+        copy = chunks.back() + chunkUsed;
+        chunkUsed += length;
+    }
+    std::memcpy(copy, label.data(), length);
+    return std::string_view(copy, length);
+}
+
+NodeId
+LabelIndex::lookup(std::string_view label) const
+{
+    Shard& shard = shardOf(label);
+    std::unique_lock<std::mutex> guard(shard.lock, std::defer_lock);
+    if (locking)
+    {
+        guard.lock();
+    }
+    Map::const_iterator it = shard.index.find(label);
+    if (it == shard.index.end())
+    {
+        return INVALID_NODE;
+    }
+    return it->second;
+}
+
+void
+LabelIndex::assign(std::string_view label, NodeId id)
+{
+    Shard& shard = shardOf(label);
+    std::unique_lock<std::mutex> guard(shard.lock, std::defer_lock);
+    if (locking)
+    {
+        guard.lock();
+    }
+    Map::iterator it = shard.index.find(label);
+    if (it != shard.index.end())
+    {
+        it->second = id;
+        return;
+    }
+    shard.index.emplace(shard.intern(label), id);
+}
+
+void
+LabelIndex::setConcurrent(bool on, unsigned count)
+{
+    locking = on;
+    if (!on || count == 0 || count == shardCount)
+    {
+        return;
+    }
+
+    // the keys are views into the old pools, so the old chunks all move
+    // to the first new shard and stay alive with it
+    Shard* moved = new Shard[count];
+    std::size_t total = size();
+    for (unsigned s = 0; s < count; s++)
+    {
+        moved[s].index.reserve(total / count + 1);
+    }
+    Shard* old = shards;
+    unsigned oldCount = shardCount;
+    shards = moved;
+    shardCount = count;
+    for (unsigned s = 0; s < oldCount; s++)
+    {
+        Map::const_iterator it;
+        for (it = old[s].index.begin(); it != old[s].index.end(); ++it)
+        {
+            shardOf(it->first).index.emplace(it->first, it->second);
+        }
+        moved[0].chunks.insert(moved[0].chunks.begin(),
+                               old[s].chunks.begin(), old[s].chunks.end());
+        moved[0].poolBytes += old[s].poolBytes;
+        old[s].chunks.clear();
+    }
+    delete [] old;
+}
+
+void
+LabelIndex::reserve(std::size_t n)
+{
+    for (unsigned s = 0; s < shardCount; s++)
+    {
+        shards[s].index.reserve(n / shardCount + 1);
+    }
+}
+
+std::size_t
+LabelIndex::size() const
+{
+    std::size_t total = 0;
+    for (unsigned s = 0; s < shardCount; s++)
+    {
+        total += shards[s].index.size();
+    }
+    return total;
+}
+
+std::size_t
+LabelIndex::memoryUsage() const
+{
+    std::size_t total = shardCount * sizeof(Shard);
+    for (unsigned s = 0; s < shardCount; s++)
+    {
+        const Map& index = shards[s].index;
+        total += shards[s].poolBytes
+               + index.bucket_count() * sizeof(void*)
+               + index.size() * (sizeof(std::string_view) + sizeof(NodeId)
+                                 + 2 * sizeof(void*));
+    }
+    return total;
+}
@@ -0,0 +1,161 @@
+/*
+* LabelIndex.h
+*/
+#ifndef LABELINDEX_H_
+#define LABELINDEX_H_
+
+#include <functional>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "GraphTypes.h"
+
+/////////////////    LabelIndex Class   //////////////////////
+
+// Hashed label -> NodeId map. Each label is copied once into a chunked
+// string pool and the table is keyed by views into that pool, so lookups
+// take a std::string_view and never build a temporary std::string.
+//
+// The table can be split into shards, each with its own map, pool and
+// lock. With locking on, lookup, assign and findOrAdd may be called from
+// several threads at once; threads only contend when their labels hash
+// to the same shard. Everything else needs exclusive access.
+class LabelIndex {
+    public:
+        typedef std::unordered_map<std::string_view, NodeId> Map;
+
+    private:
+        static const std::size_t CHUNK_SIZE = 64 * 1024;
+
+        // padded to a cache line so neighbouring locks do not false-share
+        struct alignas(64) Shard {
+            Map index;
+            std::vector<char*> chunks;
+            std::size_t chunkUsed;
+            std::size_t poolBytes;
+            std::mutex lock;
+
+            Shard() : chunkUsed(CHUNK_SIZE), poolBytes(0) {}
+
+            // copies the label into the pool and returns a view of the copy
+            std::string_view intern(std::string_view label);
+            void clear();
+        };
+
+        Shard* shards;
+        unsigned shardCount;
+        bool locking;
+
+        Shard& shardOf(std::string_view label) const {
+            if (shardCount == 1)
+            {
+                return shards[0];
+            }
+            return shards[std::hash<std::string_view>()(label) % shardCount];
+        }
+
+        // disallow copies; the map holds views into our own chunks
+        LabelIndex(const LabelIndex&);
+        LabelIndex& operator=(const LabelIndex&);
+
+    public:
+        LabelIndex();
+        ~LabelIndex();
+
+        // returns the id stored for label, or INVALID_NODE
+        NodeId lookup(std::string_view label) const;
+
+        // maps label to id, replacing any previous id
+        void assign(std::string_view label, NodeId id);
+
+        // returns resolve(id) for the id stored for label. If there is
+        // none, or it resolves to INVALID_NODE, stores and returns make()
+        // instead. The label's shard is held for the whole call, so two
+        // threads never both add the same label. Nothing is stored if
+        // make() returns INVALID_NODE
+        template <class Resolve, class Make>
+        NodeId findOrAdd(std::string_view label, Resolve resolve, Make make);
+
+        // splits the table into count shards (existing labels are moved,
+        // not copied) and turns per-shard locking on or off
+        void setConcurrent(bool on, unsigned count = 64);
+
+        bool isConcurrent() const {
+            return locking;
+        }
+
+        // drops every label
+        void clear();
+
+        // makes room for n labels in all, spread over the shards
+        void reserve(std::size_t n);
+
+        // exchanges the contents of two indexes
+        void swap(LabelIndex& other) {
+            std::swap(shards, other.shards);
+            std::swap(shardCount, other.shardCount);
+            std::swap(locking, other.locking);
+        }
+
+        std::size_t size() const;
+
+        // calls visit(label, id) for every label, in no particular order
+        template <class Visit>
+        void forEach(Visit visit) const;
+
+        // approximate heap footprint of table and pool, in bytes
+        std::size_t memoryUsage() const;
+};
+
+template <class Resolve, class Make>
+NodeId
+LabelIndex::findOrAdd(std::string_view label, Resolve resolve, Make make)
+{
+    Shard& shard = shardOf(label);
+    std::unique_lock<std::mutex> guard(shard.lock, std::defer_lock);
+    if (locking)
+    {
+        guard.lock();
+    }
+    Map::iterator it = shard.index.find(label);
+    if (it != shard.index.end())
+    {
+        NodeId id = resolve(it->second);
+        if (id != INVALID_NODE)
+        {
+            return id;
+        }
+    }
+    NodeId id = make();
+    if (id == INVALID_NODE)
+    {
+        return id;
+    }
+    if (it != shard.index.end())
+    {
+        it->second = id;
+    }
+    else
+    {
+        shard.index.emplace(shard.intern(label), id);
+    }
+    return id;
+}
+
+template <class Visit>
+void
+LabelIndex::forEach(Visit visit) const
+{
+    for (unsigned s = 0; s < shardCount; s++)
+    {
+        Map::const_iterator it;
+        for (it = shards[s].index.begin(); it != shards[s].index.end(); ++it)
+        {
+            visit(it->first, it->second);
+        }
+    }
+}
+
+#endif
@@ -2,6 +2,7 @@
 * Node.cpp
 */
 #include "Node.h"
+#include <cassert>
 
 //===-----------------------------------------------------------------===//
 /////////////////////////////////  Node Class  ////////////////////////////
@@ -9,51 +10,78 @@
 
 // Constructors / Destructor
 
-// Copy constructor
+// Copy constructor. Sharing the other Node's Edge objects would leave
+// two owners for each, so only the label is copied
 Node::Node(Node &node) 
+    : label(node.getLabel()), id(INVALID_NODE), edgePool(NULL),
+      targetIndex(NULL)
 {
-    label = node.getLabel();
-    outEdges = node.getOutEdges();
-    inEdges = node.getInEdges();
 }
 
-Node::Node(std::string labelName) : label(labelName) 
+Node::Node(std::string labelName)
+    : label(labelName), id(INVALID_NODE), edgePool(NULL), targetIndex(NULL)
 {
-    this->outEdges = new std::vector<Edge*>();
-    this->inEdges = new std::vector<Edge*>();
 }
 
 Node::Node(std::string label, Node* initialTarget) 
 {
-    this->outEdges = new std::vector<Edge*>();
-    this->inEdges = new std::vector<Edge*>();
     this->label = label;
-    this->addTarget(label);
+    this->id = INVALID_NODE;
+    this->targetIndex = NULL;
+    this->edgePool = NULL;
+    this->addTarget(initialTarget);
 }
 
 Node::~Node() 
 {
     int i;
-    if (inEdges == NULL) 
+    for(i = 0; i < (int) inEdges.size(); i++) 
     {
-        std::cerr << "Inedges null" <<std::endl;
+        Node* source = inEdges[i]->getSource();
+        source->removeOutEdge(inEdges[i]);
+        freeEdge(inEdges[i]);
     }
 
-    for(i = 0; i < (int) inEdges->size(); i++) 
+    for(i = 0; i < (int) outEdges.size(); i++) 
     {
-        Node* source = (*inEdges)[i]->getSource();
-        source->removeOutEdge((*inEdges)[i]);
-        delete (*inEdges)[i];
+        Node * target = outEdges[i]->getTarget();
+        target->removeInEdge(outEdges[i]);
+        freeEdge(outEdges[i]);
     }
+    delete targetIndex;
+}
+
+void
+Node::forgetEdges()
+{
+    outEdges.clear();
+    inEdges.clear();
+    delete targetIndex;
+    targetIndex = NULL;
+}
+
+Edge*
+Node::newEdge(Node* target, EdgeKind kind)
+{
+    if (edgePool != NULL)
+    {
+        return new (edgePool->allocate()) Edge(this, target, kind);
+    }
+    return new Edge(this, target, kind);
+}
 
-    for(i = 0; i < (int) outEdges->size(); i++) 
+void
+Node::freeEdge(Edge* edge)
+{
+    if (edgePool != NULL)
+    {
+        edge->~Edge();
+        edgePool->release(edge);
+    }
+    else
     {
-        Node * target = (*outEdges)[i]->getTarget();
-        target->removeInEdge((*outEdges)[i]);
-        delete (*outEdges)[i];
+        delete edge;
     }
-    delete inEdges;
-    delete outEdges;
 }
 
 //===-----------------------------------------------------------------===//
@@ -74,21 +102,21 @@ Node::takeLabel(Node * node)
 std::vector<Edge*> * 
 Node::getOutEdges() 
 {
-    return outEdges;
+    return &outEdges;
 }
 
 std::vector<Edge*> * 
 Node::getInEdges() 
 {
-    return inEdges;
+    return &inEdges;
 }
 
 std::vector<Node*> * 
 Node::getOutNodes() 
 {
     std::vector<Node *> * outVertices = new std::vector<Node *>();
-    std::vector<Edge *>::iterator outIterator = outEdges->begin();
-    for(; outIterator != outEdges->end(); outIterator++) 
+    std::vector<Edge *>::iterator outIterator = outEdges.begin();
+    for(; outIterator != outEdges.end(); outIterator++) 
     {
         outVertices->push_back((*outIterator)->getTarget());
     }
@@ -101,45 +129,130 @@ Node::getOutNodes()
 void 
 Node::removeInEdge(Edge* edge) 
 {
-    std::vector<Edge *>::iterator inEdgesIterator = inEdges->begin();
-    int i = 0;
-    for(; inEdgesIterator != inEdges->end(); inEdgesIterator++, i++) 
+    uint32_t slot = edge->inSlot;
+    assert(slot < inEdges.size() && inEdges[slot] == edge && "Not an in-edge");
+    Edge* last = inEdges.back();
+    inEdges[slot] = last;
+    last->inSlot = slot;
+    inEdges.pop_back();
+}
+
+void 
+Node::removeOutEdge(Edge * edge) 
+{
+    uint32_t slot = edge->outSlot;
+    assert(slot < outEdges.size() && outEdges[slot] == edge && "Not an out-edge");
+    Edge* last = outEdges.back();
+    outEdges[slot] = last;
+    last->outSlot = slot;
+    outEdges.pop_back();
+    unindexEdge(edge);
+}
+
+void
+Node::linkOut(Edge* edge)
+{
+    edge->outSlot = (uint32_t) outEdges.size();
+    outEdges.push_back(edge);
+    indexEdge(edge);
+}
+
+void
+Node::linkIn(Edge* edge)
+{
+    assert(inEdges.size() < ((std::size_t) 1 << 30) && "in-slot overflow");
+    edge->inSlot = (uint32_t) inEdges.size();
+    inEdges.push_back(edge);
+}
+
+// keeps targetIndex in step with outEdges once the Node is large enough
+// to have one; smaller nodes are searched linearly
+void
+Node::indexEdge(Edge* edge)
+{
+    if (targetIndex != NULL)
+    {
+        (*targetIndex)[edge->target] = edge;
+    }
+    else if (outEdges.size() > INDEX_THRESHOLD)
+    {
+        targetIndex = new std::unordered_map<Node*, Edge*>();
+        targetIndex->reserve(2 * outEdges.size());
+        for (std::size_t i = 0; i < outEdges.size(); i++)
+        {
+            (*targetIndex)[outEdges[i]->target] = outEdges[i];
+        }
+    }
+}
+
+void
+Node::unindexEdge(Edge* edge)
+{
+    if (targetIndex != NULL)
     {
-        if(*inEdgesIterator == edge) 
+        std::unordered_map<Node*, Edge*>::iterator it =
+            targetIndex->find(edge->target);
+        if (it != targetIndex->end() && it->second == edge)
         {
-            break;
+            targetIndex->erase(it);
         }
     }
+}
 
-    if(i < (int) inEdges->size())
-        inEdges->erase(inEdges->begin() + i);
+// points an outgoing edge of this Node at a new target, keeping the
+// index keyed by target up to date
+void
+Node::retarget(Edge* edge, Node* newTarget)
+{
+    unindexEdge(edge);
+    edge->target = newTarget;
+    if (targetIndex != NULL)
+    {
+        (*targetIndex)[newTarget] = edge;
+    }
 }
 
 void 
-Node::removeOutEdge(Edge * edge) 
+Node::addTarget(Node* targetNode, EdgeKind kind) 
 {
-    std::vector<Edge *>::iterator outEdgesIterator = outEdges->begin();
-    int i = 0;
-    for(; outEdgesIterator != outEdges->end(); outEdgesIterator++, i++) 
+    if (!alreadyHasEdge(targetNode)) 
     {
-        if(*outEdgesIterator == edge)
-            break;
+        Edge* edge = newEdge(targetNode, kind);
+        linkOut(edge);
+        targetNode->linkIn(edge);
     }
+}
 
-    if(i < (int) outEdges->size())
-        outEdges->erase(outEdges->begin() + i);
+void
+Node::attachOutEdge(Edge* edge)
+{
+    linkOut(edge);
 }
 
-void 
-Node::addTarget(Node* targetNode) 
+void
+Node::attachInEdge(Edge* edge)
 {
-    Edge* newEdge = new Edge(this, targetNode);
+    linkIn(edge);
+}
 
-    if (!alreadyHasEdge(targetNode)) 
+void
+Node::moveOutEdges(Slab<Edge>* pool)
+{
+    for (std::size_t k = 0; k < outEdges.size(); k++)
     {
-        this->outEdges->push_back(newEdge);
-        targetNode->getInEdges()->push_back(newEdge);
+        Edge* old = outEdges[k];
+        Edge* edge = new (pool->allocate())
+            Edge(this, old->target, old->getKind());
+        edge->outSlot = old->outSlot;
+        edge->inSlot = old->inSlot;
+        outEdges[k] = edge;
+        old->target->inEdges[old->inSlot] = edge;
+        if (targetIndex != NULL)
+        {
+            (*targetIndex)[old->target] = edge;
+        }
     }
+    edgePool = pool;
 }
 
 void
@@ -150,16 +263,33 @@ Node::addTarget(std::string targetVar)
 }
 
 // given another Node, this method copies every edge outgoing from
-// the other Node and adds to this one
+// the other Node whose kind is in the mask and adds to this one
 void 
-Node::addTargetsOfOther(Node * otherNode) 
+Node::addTargetsOfOther(Node * otherNode, EdgeKindMask kinds) 
+{
+    std::vector<Edge*>* copyEdges = otherNode->getOutEdges();
+    for (std::size_t i = 0; i < copyEdges->size(); i++) 
+    {
+        Edge* edgeToCopy = (*copyEdges)[i];
+        if (edgeToCopy->kind & kinds)
+        {
+            this->addTarget(edgeToCopy->getTarget(), edgeToCopy->getKind());
+        }
+    }
+}
+
+bool
+Node::removeTarget(Node* targetNode)
 {
-    std::vector<Edge*> copyEdges = *(otherNode->getOutEdges());
-    for (int i = 0; i < (int) copyEdges.size(); i++) 
+    Edge* edge = findEdge(targetNode);
+    if (edge == NULL)
     {
-        Edge* edgeToCopy = copyEdges[i];
-        this->addTarget(edgeToCopy->getTarget());
+        return false;
     }
+    removeOutEdge(edge);
+    targetNode->removeInEdge(edge);
+    freeEdge(edge);
+    return true;
 }
 
 // check if a Node has an edge to the input target Node
@@ -167,16 +297,126 @@ Node::addTargetsOfOther(Node * otherNode)
 bool 
 Node::alreadyHasEdge(Node * targetNode) 
 {
-    std::vector<Node *> outVertices =  *(this->getOutNodes());
-    std::vector<Node *>::iterator it = outVertices.begin();
-    for (; it != outVertices.end(); it++) 
+    return findEdge(targetNode) != NULL;
+}
+
+// returns the edge from this Node to the target, or NULL. Hashed once
+// the out-degree passes INDEX_THRESHOLD, a short scan below that
+Edge*
+Node::findEdge(Node * targetNode)
+{
+    if (targetIndex != NULL)
+    {
+        std::unordered_map<Node*, Edge*>::iterator it =
+            targetIndex->find(targetNode);
+        return it == targetIndex->end() ? NULL : it->second;
+    }
+    for (std::size_t i = 0; i < outEdges.size(); i++)
     {
-        if (*it == targetNode) 
+        if (outEdges[i]->target == targetNode)
+        {
+            return outEdges[i];
+        }
+    }
+    return NULL;
+}
+
+std::size_t
+Node::adjacencyBytes() const
+{
+    std::size_t bytes = (outEdges.capacity() + inEdges.capacity())
+                      * sizeof(Edge*);
+    if (targetIndex != NULL)
+    {
+        bytes += targetIndex->bucket_count() * sizeof(void*)
+               + targetIndex->size() * (sizeof(Node*) + sizeof(Edge*)
+                                        + sizeof(void*));
+    }
+    return bytes;
+}
+
+// the edge kept when two edges between the same nodes become one is a
+// must-edge only if both were
+void
+Node::meetKinds(Edge* kept, Edge* dropped)
+{
+    if (kept->getKind() != dropped->getKind())
+    {
+        kept->kind = EDGE_MAY;
+    }
+}
+
+void
+Node::absorb(Node* other)
+{
+    if (other == this)
+    {
+        return;
+    }
+    std::size_t i;
+
+    // outgoing edges: other -> T becomes this -> T
+    std::vector<Edge*>* otherOut = &other->outEdges;
+    for (i = 0; i < otherOut->size(); i++)
+    {
+        Edge* edge = (*otherOut)[i];
+        Node* target = edge->target;
+        if (target == other)
+        {
+            // self-loop; handled with the incoming edges below
+            continue;
+        }
+        Edge* kept = findEdge(target);
+        if (kept == NULL)
+        {
+            edge->source = this;
+            linkOut(edge);
+        }
+        else
+        {
+            meetKinds(kept, edge);
+            target->removeInEdge(edge);
+            freeEdge(edge);
+        }
+    }
+    otherOut->clear();
+    delete other->targetIndex;
+    other->targetIndex = NULL;
+
+    // incoming edges: S -> other becomes S -> this
+    std::vector<Edge*>* otherIn = &other->inEdges;
+    for (i = 0; i < otherIn->size(); i++)
+    {
+        Edge* edge = (*otherIn)[i];
+        Node* source = edge->source;
+        if (source == other)
+        {
+            // other -> other becomes this -> this
+            Edge* kept = findEdge(this);
+            if (kept != NULL)
+            {
+                meetKinds(kept, edge);
+                freeEdge(edge);
+                continue;
+            }
+            edge->source = this;
+            edge->target = this;
+            linkOut(edge);
+        }
+        else if (Edge* kept = source->findEdge(this))
+        {
+            meetKinds(kept, edge);
+            source->removeOutEdge(edge);
+            freeEdge(edge);
+            continue;
+        }
+        else
         {
-            return true;
+            source->retarget(edge, this);
         }
+        linkIn(edge);
     }
-    return false;
+    otherIn->clear();
 }
 
 std::string 
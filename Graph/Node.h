@@ -13,7 +13,10 @@
 #include <set>
 #include <vector>
 #include <string>
+#include <unordered_map>
 #include "Edge.h"
+#include "GraphTypes.h"
+#include "Slab.h"
 
 class Edge;
 
@@ -22,11 +25,40 @@ class Edge;
 class Node {
     private:
         std::string label;
-        std::vector<Edge*> *outEdges;
-        std::vector<Edge*> *inEdges;
+        NodeId id;              // slot in the owning Graph, if any
+        std::vector<Edge*> outEdges;
+        std::vector<Edge*> inEdges;
+
+        // pool the owning Graph allocates edges from; NULL for a
+        // free-standing Node, whose edges live on the heap
+        Slab<Edge> *edgePool;
+
+        Edge* newEdge(Node* target, EdgeKind kind);
+        void freeEdge(Edge* edge);
+
+        // target -> edge, built only for high out-degree nodes so that
+        // duplicate checks stay O(1) without slowing down small nodes
+        std::unordered_map<Node*, Edge*> *targetIndex;
+        static const std::size_t INDEX_THRESHOLD = 16;
+
+        void indexEdge(Edge* edge);
+        void unindexEdge(Edge* edge);
+
+        // disallow assignment; edges have a single owner
+        Node& operator=(const Node&);
+        void retarget(Edge* edge, Node* newTarget);
+
+        // append an edge to outEdges (resp. inEdges), recording its slot
+        void linkOut(Edge* edge);
+        void linkIn(Edge* edge);
+
+        // settles the kind of an edge that a duplicate was folded into
+        static void meetKinds(Edge* kept, Edge* dropped);
 
     public:
-        // copy constructor
+        // copy constructor. The copy has the same label but no edges
+        // and belongs to no graph; Graph's copy constructor copies nodes
+        // together with their edges
         Node(Node &node);
 
         // make a Node with no outgoing edges
@@ -39,8 +71,19 @@ class Node {
         ~Node();
 
         std::string getLabel();
+        const std::string& getLabelRef() const { return label; }
         void takeLabel(Node* other);
 
+        NodeId getId() const { return id; }
+        void setId(NodeId newId) { id = newId; }
+
+        // must be set before the Node gets any edges
+        void setEdgePool(Slab<Edge>* pool) { edgePool = pool; }
+
+        // empties both edge lists without unlinking or freeing the edges.
+        // Only for bulk teardown, when every edge is released at once
+        void forgetEdges();
+
         std::vector<Edge*> *getOutEdges();
         std::vector<Edge*> *getInEdges();
 
@@ -48,21 +91,57 @@ class Node {
         // i.e the nodes the outedges point to
         std::vector<Node*> *getOutNodes();
 
+        // unlink an edge of this Node in constant time by moving the last
+        // edge of the list into its slot, so the order of the remaining
+        // edges is not kept. The edge itself is not freed
         void removeInEdge(Edge* edge);
         void removeOutEdge(Edge* edge);
 
-        // add an edge to a pre-constructed target Node
-        void addTarget(Node* targetNode);
+        // add an edge to a pre-constructed target Node. If there already
+        // is one, it keeps its kind
+        void addTarget(Node* targetNode, EdgeKind kind = EDGE_MAY);
         // add an edge to a newly constructed Node
         void addTarget(std::string targetVar);
         // given another Node, this method copies every edge outgoing
-        // from the other Node and adds to this one
-        void addTargetsOfOther(Node* otherNode);
+        // from the other Node whose kind is in the mask, with its kind,
+        // and adds to this one
+        void addTargetsOfOther(Node* otherNode,
+                               EdgeKindMask kinds = ALL_EDGE_KINDS);
+        // unlinks and frees the edge to the input target Node. Returns
+        // false if there is none
+        bool removeTarget(Node* targetNode);
+
+        // low-level hooks for bulk builders: link an edge that was
+        // constructed with this Node as its source (resp. target) from
+        // the same pool. No duplicate check is done
+        void attachOutEdge(Edge* edge);
+        void attachInEdge(Edge* edge);
+
+        // low-level hook for relocating edges: copies every out-edge of
+        // this Node into the given pool, keeping its slot in both edge
+        // lists, and makes the pool this Node's own. The old edges are
+        // not freed
+        void moveOutEdges(Slab<Edge>* pool);
 
         // check if a Node has an edge to the input target Node
         // (used so don't add duplicates in addTargetsOfOther
         bool alreadyHasEdge(Node* targetNode);
 
+        // returns the edge to the input target Node, or NULL if none.
+        // Amortized O(1) and never allocates
+        Edge* findEdge(Node* targetNode);
+
+        // approximate heap bytes held by the edge lists and the target
+        // index (not by the edges themselves)
+        std::size_t adjacencyBytes() const;
+
+        // moves every edge of the other Node onto this one, rewiring the
+        // existing Edge objects in place and dropping the ones that would
+        // duplicate an edge this Node already has; if the two differ in
+        // kind, the one kept becomes a may-edge. Edges between the two
+        // nodes become self-loops. The other Node is left without edges.
+        void absorb(Node* other);
+
         std::string toString();
 };
 #endif
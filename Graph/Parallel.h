@@ -0,0 +1,120 @@
+/*
+* Parallel.h
+* ----------
+* Small std::thread helpers shared by the bulk graph builders and
+* traversals: a chunked parallel for and a parallel merge sort.
+*/
+#ifndef PARALLEL_H_
+#define PARALLEL_H_
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+// number of threads to use when the caller passes 0
+inline unsigned
+hardwareThreads()
+{
+    unsigned n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+}
+
+// splits [begin, end) into one contiguous chunk per thread and calls
+// fn(chunkBegin, chunkEnd, threadIndex) on each, the last chunk on the
+// calling thread. threads == 0 means hardwareThreads()
+template <class Function>
+void
+parallelFor(std::size_t begin, std::size_t end, unsigned threads, Function fn)
+{
+    if (threads == 0)
+    {
+        threads = hardwareThreads();
+    }
+    std::size_t total = end - begin;
+    if (threads > total)
+    {
+        threads = total == 0 ? 1 : (unsigned) total;
+    }
+    if (threads == 1)
+    {
+        fn(begin, end, 0u);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    std::size_t chunk = (total + threads - 1) / threads;
+    for (unsigned t = 0; t + 1 < threads; t++)
+    {
+        std::size_t lo = begin + t * chunk;
+        std::size_t hi = std::min(end, lo + chunk);
+        workers.push_back(std::thread(fn, lo, hi, t));
+    }
+    fn(begin + (threads - 1) * chunk, end, threads - 1);
+    for (std::size_t i = 0; i < workers.size(); i++)
+    {
+        workers[i].join();
+    }
+}
+
+// sorts each of up to `threads` slices of v concurrently, then merges
+// neighboring runs pairwise, also concurrently, until one run is left
+template <class T, class Compare>
+void
+parallelSort(std::vector<T>& v, Compare cmp, unsigned threads)
+{
+    if (threads == 0)
+    {
+        threads = hardwareThreads();
+    }
+    // not worth spinning up threads for small inputs
+    if (threads == 1 || v.size() < 65536)
+    {
+        std::sort(v.begin(), v.end(), cmp);
+        return;
+    }
+
+    std::size_t chunk = (v.size() + threads - 1) / threads;
+    std::vector<std::size_t> bounds;
+    for (std::size_t lo = 0; lo < v.size(); lo += chunk)
+    {
+        bounds.push_back(lo);
+    }
+    bounds.push_back(v.size());
+
+    parallelFor(0, bounds.size() - 1, threads,
+        [&](std::size_t lo, std::size_t hi, unsigned)
+        {
+            for (std::size_t r = lo; r < hi; r++)
+            {
+                std::sort(v.begin() + bounds[r], v.begin() + bounds[r + 1], cmp);
+            }
+        });
+
+    while (bounds.size() > 2)
+    {
+        std::size_t pairs = (bounds.size() - 1) / 2;
+        parallelFor(0, pairs, threads,
+            [&](std::size_t lo, std::size_t hi, unsigned)
+            {
+                for (std::size_t p = lo; p < hi; p++)
+                {
+                    std::inplace_merge(v.begin() + bounds[2 * p],
+                                       v.begin() + bounds[2 * p + 1],
+                                       v.begin() + bounds[2 * p + 2], cmp);
+                }
+            });
+
+        std::vector<std::size_t> merged;
+        for (std::size_t i = 0; i < bounds.size(); i += 2)
+        {
+            merged.push_back(bounds[i]);
+        }
+        if (merged.back() != v.size())
+        {
+            merged.push_back(v.size());
+        }
+        bounds.swap(merged);
+    }
+}
+
+#endif
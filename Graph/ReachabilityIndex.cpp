@@ -0,0 +1,322 @@
+/*
+* ReachabilityIndex.cpp
+*/
+#include "ReachabilityIndex.h"
+#include "SCC.h"
+#include <algorithm>
+#include <utility>
+
+//===-----------------------------------------------------------------===//
+//////////////////////  ReachabilityIndex Class  //////////////////////////
+//===-----------------------------------------------------------------===//
+
+const NodeId ReachabilityIndex::CLOSURE_LIMIT;
+const unsigned ReachabilityIndex::LABELINGS;
+
+ReachabilityIndex::ReachabilityIndex(const CSRGraph& graph)
+    : componentCount(0), rowWords(0), visitStamp(0)
+{
+    buildDag(graph);
+    buildQueries();
+}
+
+ReachabilityIndex::ReachabilityIndex(const CompressedCSRGraph& graph)
+    : componentCount(0), rowWords(0), visitStamp(0)
+{
+    buildDag(graph);
+    buildQueries();
+}
+
+ReachabilityIndex::ReachabilityIndex(const KindFilter<CSRGraph>& graph)
+    : componentCount(0), rowWords(0), visitStamp(0)
+{
+    buildDag(graph);
+    buildQueries();
+}
+
+ReachabilityIndex::ReachabilityIndex(
+    const KindFilter<CompressedCSRGraph>& graph)
+    : componentCount(0), rowWords(0), visitStamp(0)
+{
+    buildDag(graph);
+    buildQueries();
+}
+
+// picks the closure or the labels depending on the size of the DAG
+void
+ReachabilityIndex::buildQueries()
+{
+    if (componentCount <= CLOSURE_LIMIT)
+    {
+        buildClosure();
+        return;
+    }
+    buildTreeCover();
+    for (unsigned i = 0; i < LABELINGS; i++)
+    {
+        buildLabels(i);
+    }
+    visitMark.assign(componentCount, 0);
+}
+
+// collapses the components and keeps one copy of each edge between two
+// of them
+template <class G>
+void
+ReachabilityIndex::buildDag(const G& graph)
+{
+    componentCount = findSCCs(graph, component);
+    NodeId n = graph.numNodes();
+
+    dagOffsets.assign(componentCount + 1, 0);
+    NodeId v;
+    for (v = 0; v < n; v++)
+    {
+        typename G::NeighborRange targets = graph.outNeighbors(v);
+        typename G::NeighborRange::const_iterator k;
+        for (k = targets.begin(); k != targets.end(); ++k)
+        {
+            if (component[*k] != component[v])
+            {
+                dagOffsets[component[v] + 1]++;
+            }
+        }
+    }
+    for (NodeId c = 0; c < componentCount; c++)
+    {
+        dagOffsets[c + 1] += dagOffsets[c];
+    }
+
+    dagTargets.resize(dagOffsets[componentCount]);
+    std::vector<EdgeOffset> fill(dagOffsets.begin(), dagOffsets.end() - 1);
+    for (v = 0; v < n; v++)
+    {
+        typename G::NeighborRange targets = graph.outNeighbors(v);
+        typename G::NeighborRange::const_iterator k;
+        for (k = targets.begin(); k != targets.end(); ++k)
+        {
+            if (component[*k] != component[v])
+            {
+                dagTargets[fill[component[v]]++] = component[*k];
+            }
+        }
+    }
+
+    // sort and deduplicate each row, compacting in place
+    EdgeOffset out = 0;
+    for (NodeId c = 0; c < componentCount; c++)
+    {
+        std::vector<NodeId>::iterator first = dagTargets.begin() + dagOffsets[c];
+        std::vector<NodeId>::iterator last = dagTargets.begin() + dagOffsets[c + 1];
+        std::sort(first, last);
+        last = std::unique(first, last);
+        dagOffsets[c] = out;
+        out = std::copy(first, last, dagTargets.begin() + out) - dagTargets.begin();
+    }
+    dagOffsets[componentCount] = out;
+    dagTargets.resize(out);
+}
+
+// successors have lower ids, so rows are complete by the time they are
+// or-ed into a predecessor's
+void
+ReachabilityIndex::buildClosure()
+{
+    rowWords = ((std::size_t) componentCount + 63) / 64;
+    closure.assign(componentCount * rowWords, 0);
+    for (NodeId c = 0; c < componentCount; c++)
+    {
+        uint64_t* row = &closure[c * rowWords];
+        row[c >> 6] |= (uint64_t) 1 << (c & 63);
+        for (EdgeOffset e = dagOffsets[c]; e < dagOffsets[c + 1]; e++)
+        {
+            const uint64_t* other = &closure[dagTargets[e] * rowWords];
+            // d < c, so only the words up to c's can have bits
+            for (std::size_t w = 0; w <= (c >> 6); w++)
+            {
+                row[w] |= other[w];
+            }
+        }
+    }
+}
+
+// pre-order intervals of a DFS spanning forest, roots taken in
+// topological order (highest id first)
+void
+ReachabilityIndex::buildTreeCover()
+{
+    treeFirst.assign(componentCount, INVALID_NODE);
+    treeLast.assign(componentCount, 0);
+    std::vector<std::pair<NodeId, EdgeOffset> > frames;
+    NodeId counter = 0;
+
+    for (NodeId root = componentCount; root-- > 0; )
+    {
+        if (treeFirst[root] != INVALID_NODE)
+        {
+            continue;
+        }
+        treeFirst[root] = counter++;
+        frames.push_back(std::make_pair(root, dagOffsets[root]));
+        while (!frames.empty())
+        {
+            NodeId c = frames.back().first;
+            EdgeOffset& next = frames.back().second;
+            if (next < dagOffsets[c + 1])
+            {
+                NodeId d = dagTargets[next++];
+                if (treeFirst[d] == INVALID_NODE)
+                {
+                    treeFirst[d] = counter++;
+                    frames.push_back(std::make_pair(d, dagOffsets[d]));
+                }
+                continue;
+            }
+            treeLast[c] = counter - 1;
+            frames.pop_back();
+        }
+    }
+}
+
+// one GRAIL labeling: post-order numbers of a DFS, and for each node the
+// lowest number among everything below it. Odd labelings visit roots and
+// children in the opposite order, so the two disagree as much as possible
+void
+ReachabilityIndex::buildLabels(unsigned labeling)
+{
+    std::vector<NodeId>& low = labelLow[labeling];
+    std::vector<NodeId>& post = labelPost[labeling];
+    low.assign(componentCount, INVALID_NODE);
+    post.assign(componentCount, INVALID_NODE);
+    std::vector<char> started(componentCount, 0);
+    std::vector<std::pair<NodeId, EdgeOffset> > frames;
+    bool reversed = labeling % 2 == 1;
+    NodeId counter = 0;
+
+    for (NodeId i = 0; i < componentCount; i++)
+    {
+        NodeId root = reversed ? i : componentCount - 1 - i;
+        if (started[root])
+        {
+            continue;
+        }
+        started[root] = 1;
+        frames.push_back(std::make_pair(root, (EdgeOffset) 0));
+        while (!frames.empty())
+        {
+            NodeId c = frames.back().first;
+            EdgeOffset& next = frames.back().second;
+            EdgeOffset degree = dagOffsets[c + 1] - dagOffsets[c];
+            if (next < degree)
+            {
+                EdgeOffset k = reversed ? dagOffsets[c + 1] - 1 - next
+                                        : dagOffsets[c] + next;
+                next++;
+                NodeId d = dagTargets[k];
+                if (!started[d])
+                {
+                    started[d] = 1;
+                    frames.push_back(std::make_pair(d, (EdgeOffset) 0));
+                }
+                continue;
+            }
+            post[c] = counter++;
+            NodeId lowest = post[c];
+            for (EdgeOffset e = dagOffsets[c]; e < dagOffsets[c + 1]; e++)
+            {
+                lowest = std::min(lowest, low[dagTargets[e]]);
+            }
+            low[c] = lowest;
+            frames.pop_back();
+        }
+    }
+}
+
+// false only if from certainly does not reach to
+bool
+ReachabilityIndex::mayReach(NodeId from, NodeId to) const
+{
+    if (from < to)
+    {
+        return false;
+    }
+    for (unsigned i = 0; i < LABELINGS; i++)
+    {
+        if (labelLow[i][to] < labelLow[i][from]
+            || labelPost[i][to] > labelPost[i][from])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool
+ReachabilityIndex::reaches(NodeId from, NodeId to) const
+{
+    NodeId source = component[from];
+    NodeId target = component[to];
+    if (source == target)
+    {
+        return true;
+    }
+    if (!closure.empty())
+    {
+        return (closure[source * rowWords + (target >> 6)] >> (target & 63)) & 1;
+    }
+    if (treeReaches(source, target))
+    {
+        return true;
+    }
+    if (!mayReach(source, target))
+    {
+        return false;
+    }
+
+    // search the DAG, skipping whatever the labels rule out
+    if (++visitStamp == 0)
+    {
+        std::fill(visitMark.begin(), visitMark.end(), 0);
+        visitStamp = 1;
+    }
+    visitStack.clear();
+    visitStack.push_back(source);
+    visitMark[source] = visitStamp;
+    while (!visitStack.empty())
+    {
+        NodeId c = visitStack.back();
+        visitStack.pop_back();
+        for (EdgeOffset e = dagOffsets[c]; e < dagOffsets[c + 1]; e++)
+        {
+            NodeId d = dagTargets[e];
+            if (d == target || treeReaches(d, target))
+            {
+                return true;
+            }
+            if (visitMark[d] != visitStamp && mayReach(d, target))
+            {
+                visitMark[d] = visitStamp;
+                visitStack.push_back(d);
+            }
+        }
+    }
+    return false;
+}
+
+std::size_t
+ReachabilityIndex::memoryUsage() const
+{
+    std::size_t bytes = sizeof(ReachabilityIndex)
+        + component.capacity() * sizeof(NodeId)
+        + dagOffsets.capacity() * sizeof(EdgeOffset)
+        + dagTargets.capacity() * sizeof(NodeId)
+        + closure.capacity() * sizeof(uint64_t)
+        + (treeFirst.capacity() + treeLast.capacity()) * sizeof(NodeId)
+        + visitMark.capacity() * sizeof(unsigned)
+        + visitStack.capacity() * sizeof(NodeId);
+    for (unsigned i = 0; i < LABELINGS; i++)
+    {
+        bytes += (labelLow[i].capacity() + labelPost[i].capacity()) * sizeof(NodeId);
+    }
+    return bytes;
+}
@@ -0,0 +1,97 @@
+/*
+* ReachabilityIndex.h
+*/
+#ifndef REACHABILITYINDEX_H_
+#define REACHABILITYINDEX_H_
+
+#include <stdint.h>
+#include <vector>
+#include "CSRGraph.h"
+#include "CompressedCSRGraph.h"
+#include "KindFilter.h"
+
+/////////////////    ReachabilityIndex Class   //////////////////////
+
+// Answers "does u reach v" on a frozen graph without a full traversal.
+// Strongly connected components are collapsed first; queries then work
+// on the condensation DAG:
+//  - with at most CLOSURE_LIMIT components the whole transitive closure
+//    is stored as one bit row per component, and a query is a bit test;
+//  - larger DAGs get interval labels instead. A pre-order interval of a
+//    DFS spanning forest proves reachability along tree edges, and two
+//    post-order labelings (GRAIL) prove non-reachability for most other
+//    pairs. The rest fall back to a DFS pruned by the same labels.
+// Queries are not safe to run concurrently (the fallback DFS shares a
+// scratch area).
+class ReachabilityIndex {
+    public:
+        static const NodeId CLOSURE_LIMIT = 8192;
+
+    private:
+        // frozen id -> component; components are in reverse topological
+        // order, so every DAG edge goes from a higher id to a lower one
+        std::vector<NodeId> component;
+        NodeId componentCount;
+
+        // condensation DAG
+        std::vector<EdgeOffset> dagOffsets;
+        std::vector<NodeId> dagTargets;
+
+        // transitive closure: row c, bit d set if c reaches d
+        std::size_t rowWords;
+        std::vector<uint64_t> closure;
+
+        // tree cover: the subtree of c is [treeFirst[c], treeLast[c]]
+        std::vector<NodeId> treeFirst;
+        std::vector<NodeId> treeLast;
+
+        // GRAIL labels, LABELINGS pairs of (lowest post-order number
+        // below c, post-order number of c)
+        static const unsigned LABELINGS = 2;
+        std::vector<NodeId> labelLow[LABELINGS];
+        std::vector<NodeId> labelPost[LABELINGS];
+
+        // scratch for the fallback search
+        mutable std::vector<unsigned> visitMark;
+        mutable unsigned visitStamp;
+        mutable std::vector<NodeId> visitStack;
+
+        template <class G>
+        void buildDag(const G& graph);
+        void buildQueries();
+        void buildClosure();
+        void buildTreeCover();
+        void buildLabels(unsigned labeling);
+
+        bool mayReach(NodeId from, NodeId to) const;
+        bool treeReaches(NodeId from, NodeId to) const {
+            return treeFirst[from] <= treeFirst[to]
+                && treeFirst[to] <= treeLast[from];
+        }
+
+    public:
+        explicit ReachabilityIndex(const CSRGraph& graph);
+        explicit ReachabilityIndex(const CompressedCSRGraph& graph);
+
+        // an index over the edges a filtered view keeps
+        explicit ReachabilityIndex(const KindFilter<CSRGraph>& graph);
+        explicit ReachabilityIndex(const KindFilter<CompressedCSRGraph>& graph);
+
+        // given two frozen ids, returns true if there is a path from
+        // `from` to `to` (every node reaches itself)
+        bool reaches(NodeId from, NodeId to) const;
+
+        NodeId numComponents() const {
+            return componentCount;
+        }
+
+        // true if queries are answered from the stored closure
+        bool hasClosure() const {
+            return !closure.empty() || componentCount == 0;
+        }
+
+        // approximate heap footprint, in bytes
+        std::size_t memoryUsage() const;
+};
+
+#endif
@@ -0,0 +1,372 @@
+/*
+* SCC.cpp
+*/
+#include "SCC.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <utility>
+
+//===-----------------------------------------------------------------===//
+// Iterative Tarjan
+//
+// A node is on the Tarjan stack exactly when it has been numbered but
+// not yet assigned a component, so no separate on-stack flags are kept.
+
+// a node on the DFS path and the neighbors it has left to visit
+template <class G>
+struct TarjanFrame {
+    NodeId node;
+    typename G::NeighborRange::const_iterator next;
+    typename G::NeighborRange::const_iterator end;
+
+    TarjanFrame(NodeId v, const typename G::NeighborRange& targets)
+        : node(v), next(targets.begin()), end(targets.end()) {}
+};
+
+// runs one Tarjan search from root, following only edges to nodes for
+// which inScope() holds, and numbers the components it closes from
+// `components` on. index, low, component, stack and frames are shared
+// between calls; counter and components carry over
+template <class G, class InScope>
+static void
+tarjanFrom(const G& graph, NodeId root, InScope inScope,
+           std::vector<NodeId>& component, std::vector<NodeId>& index,
+           std::vector<NodeId>& low, std::vector<NodeId>& stack,
+           std::vector<TarjanFrame<G> >& frames,
+           NodeId& counter, NodeId& components)
+{
+    index[root] = low[root] = counter++;
+    stack.push_back(root);
+    frames.push_back(TarjanFrame<G>(root, graph.outNeighbors(root)));
+
+    while (!frames.empty())
+    {
+        TarjanFrame<G>& frame = frames.back();
+        NodeId v = frame.node;
+
+        if (frame.next != frame.end)
+        {
+            NodeId w = *frame.next;
+            ++frame.next;
+            if (!inScope(w))
+            {
+                continue;
+            }
+            if (index[w] == INVALID_NODE)
+            {
+                index[w] = low[w] = counter++;
+                stack.push_back(w);
+                frames.push_back(TarjanFrame<G>(w, graph.outNeighbors(w)));
+            }
+            else if (component[w] == INVALID_NODE)
+            {
+                low[v] = std::min(low[v], index[w]);
+            }
+            continue;
+        }
+
+        // all neighbors done: v closes a component if it is its root
+        if (low[v] == index[v])
+        {
+            NodeId w;
+            do
+            {
+                w = stack.back();
+                stack.pop_back();
+                component[w] = components;
+            } while (w != v);
+            components++;
+        }
+        frames.pop_back();
+        if (!frames.empty())
+        {
+            NodeId parent = frames.back().node;
+            low[parent] = std::min(low[parent], low[v]);
+        }
+    }
+}
+
+template <class G>
+static NodeId
+serialSCCs(const G& graph, std::vector<NodeId>& component)
+{
+    NodeId n = graph.numNodes();
+    component.assign(n, INVALID_NODE);
+    std::vector<NodeId> index(n, INVALID_NODE);
+    std::vector<NodeId> low(n);
+    std::vector<NodeId> stack;
+    std::vector<TarjanFrame<G> > frames;
+    NodeId counter = 0;
+    NodeId components = 0;
+
+    for (NodeId root = 0; root < n; root++)
+    {
+        if (index[root] == INVALID_NODE)
+        {
+            tarjanFrom(graph, root, [](NodeId) { return true; }, component,
+                       index, low, stack, frames, counter, components);
+        }
+    }
+    return components;
+}
+
+//===-----------------------------------------------------------------===//
+// Parallel forward-backward search with trimming
+
+// marks in flags (with `bit`) every node reachable from pivot through
+// live nodes, following out-edges (forward) or in-edges, one BFS level
+// at a time with the frontier split across threads
+template <class G>
+static void
+markReachable(const G& graph, NodeId pivot, bool forward,
+              const std::vector<char>& live,
+              std::vector<std::atomic<unsigned char> >& flags,
+              unsigned char bit, unsigned threads)
+{
+    std::vector<NodeId> frontier(1, pivot);
+    flags[pivot].fetch_or(bit);
+    std::vector<std::vector<NodeId> > found(threads);
+
+    while (!frontier.empty())
+    {
+        // narrow levels are not worth starting threads for; long chains
+        // have many of them
+        unsigned levelThreads = frontier.size() < 4096 ? 1 : threads;
+        parallelFor(0, frontier.size(), levelThreads,
+            [&](std::size_t lo, std::size_t hi, unsigned t)
+            {
+                for (std::size_t i = lo; i < hi; i++)
+                {
+                    typename G::NeighborRange next = forward
+                        ? graph.outNeighbors(frontier[i])
+                        : graph.inNeighbors(frontier[i]);
+                    typename G::NeighborRange::const_iterator k;
+                    for (k = next.begin(); k != next.end(); ++k)
+                    {
+                        NodeId w = *k;
+                        if (live[w] && !(flags[w].load() & bit)
+                            && !(flags[w].fetch_or(bit) & bit))
+                        {
+                            found[t].push_back(w);
+                        }
+                    }
+                }
+            });
+        frontier.clear();
+        for (unsigned t = 0; t < levelThreads; t++)
+        {
+            frontier.insert(frontier.end(), found[t].begin(), found[t].end());
+            found[t].clear();
+        }
+    }
+}
+
+template <class G>
+static NodeId
+parallelSCCs(const G& graph, std::vector<NodeId>& component, unsigned threads)
+{
+    if (threads == 0)
+    {
+        threads = hardwareThreads();
+    }
+    NodeId n = graph.numNodes();
+    component.assign(n, INVALID_NODE);
+    if (n == 0)
+    {
+        return 0;
+    }
+
+    // trimming: a node without a live predecessor or successor is a
+    // component by itself. Chains peel off one node per round, so stop
+    // once a round removes little
+    std::vector<char> live(n, 1);
+    std::vector<char> trimmed(n, 0);
+    std::size_t remaining = n;
+    for (;;)
+    {
+        std::vector<std::size_t> removed(threads, 0);
+        parallelFor(0, n, threads,
+            [&](std::size_t lo, std::size_t hi, unsigned t)
+            {
+                for (std::size_t v = lo; v < hi; v++)
+                {
+                    if (!live[v])
+                    {
+                        continue;
+                    }
+                    bool hasOut = false;
+                    bool hasIn = false;
+                    typename G::NeighborRange out = graph.outNeighbors((NodeId) v);
+                    typename G::NeighborRange::const_iterator k;
+                    for (k = out.begin(); k != out.end() && !hasOut; ++k)
+                    {
+                        hasOut = live[*k] && *k != v;
+                    }
+                    typename G::NeighborRange in = graph.inNeighbors((NodeId) v);
+                    for (k = in.begin(); k != in.end() && !hasIn; ++k)
+                    {
+                        hasIn = live[*k] && *k != v;
+                    }
+                    if (!hasOut || !hasIn)
+                    {
+                        trimmed[v] = 1;
+                        removed[t]++;
+                    }
+                }
+            });
+        std::size_t total = 0;
+        for (unsigned t = 0; t < threads; t++)
+        {
+            total += removed[t];
+        }
+        for (NodeId v = 0; v < n; v++)
+        {
+            if (trimmed[v])
+            {
+                live[v] = 0;
+            }
+        }
+        remaining -= total;
+        if (total == 0 || total * 100 < remaining)
+        {
+            break;
+        }
+    }
+
+    // forward-backward from the live node most likely to sit in a large
+    // component; the nodes reached both ways form its component
+    std::vector<std::atomic<unsigned char> > flags(n);
+    const unsigned char FORWARD = 1, BACKWARD = 2;
+    NodeId pivot = INVALID_NODE;
+    std::size_t best = 0;
+    for (NodeId v = 0; v < n; v++)
+    {
+        std::size_t score = (graph.outDegree(v) + 1) * (graph.inDegree(v) + 1);
+        if (live[v] && (pivot == INVALID_NODE || score > best))
+        {
+            pivot = v;
+            best = score;
+        }
+    }
+    if (pivot != INVALID_NODE)
+    {
+        markReachable(graph, pivot, true, live, flags, FORWARD, threads);
+        markReachable(graph, pivot, false, live, flags, BACKWARD, threads);
+    }
+
+    // every other live node is reached forward only, backward only or
+    // neither, and no component spans two of those sets, so each is
+    // searched by its own Tarjan pass on its own thread
+    const unsigned char BOTH = FORWARD | BACKWARD;
+    std::vector<NodeId> index(n, INVALID_NODE);
+    std::vector<NodeId> low(n);
+    NodeId partCount[BOTH] = { 0, 0, 0 };
+    parallelFor(0, BOTH, threads,
+        [&](std::size_t lo, std::size_t hi, unsigned)
+        {
+            for (std::size_t part = lo; part < hi; part++)
+            {
+                std::vector<NodeId> stack;
+                std::vector<TarjanFrame<G> > frames;
+                NodeId counter = 0;
+                NodeId components = 0;
+                unsigned char tag = (unsigned char) part;
+                for (NodeId root = 0; root < n; root++)
+                {
+                    if (live[root] && flags[root].load() == tag
+                        && index[root] == INVALID_NODE)
+                    {
+                        tarjanFrom(graph, root,
+                            [&](NodeId w)
+                            {
+                                return live[w] && flags[w].load() == tag;
+                            },
+                            component, index, low, stack, frames,
+                            counter, components);
+                    }
+                }
+                partCount[part] = components;
+            }
+        });
+
+    // number the parts one after another, then the pivot's component,
+    // then the trimmed nodes
+    NodeId offset[BOTH];
+    NodeId components = 0;
+    for (unsigned part = 0; part < BOTH; part++)
+    {
+        offset[part] = components;
+        components += partCount[part];
+    }
+    NodeId pivotComponent = pivot != INVALID_NODE ? components++ : INVALID_NODE;
+    for (NodeId v = 0; v < n; v++)
+    {
+        if (!live[v])
+        {
+            component[v] = components++;
+        }
+        else if (flags[v].load() == BOTH)
+        {
+            component[v] = pivotComponent;
+        }
+        else
+        {
+            component[v] += offset[flags[v].load()];
+        }
+    }
+    return components;
+}
+
+NodeId
+findSCCs(const CSRGraph& graph, std::vector<NodeId>& component)
+{
+    return serialSCCs(graph, component);
+}
+
+NodeId
+findSCCs(const CompressedCSRGraph& graph, std::vector<NodeId>& component)
+{
+    return serialSCCs(graph, component);
+}
+
+NodeId
+findSCCs(const KindFilter<CSRGraph>& graph, std::vector<NodeId>& component)
+{
+    return serialSCCs(graph, component);
+}
+
+NodeId
+findSCCs(const KindFilter<CompressedCSRGraph>& graph,
+         std::vector<NodeId>& component)
+{
+    return serialSCCs(graph, component);
+}
+
+NodeId
+findSCCsParallel(const CSRGraph& graph, std::vector<NodeId>& component,
+                 unsigned threads)
+{
+    return parallelSCCs(graph, component, threads);
+}
+
+NodeId
+findSCCsParallel(const CompressedCSRGraph& graph,
+                 std::vector<NodeId>& component, unsigned threads)
+{
+    return parallelSCCs(graph, component, threads);
+}
+
+NodeId
+findSCCsParallel(const KindFilter<CSRGraph>& graph,
+                 std::vector<NodeId>& component, unsigned threads)
+{
+    return parallelSCCs(graph, component, threads);
+}
+
+NodeId
+findSCCsParallel(const KindFilter<CompressedCSRGraph>& graph,
+                 std::vector<NodeId>& component, unsigned threads)
+{
+    return parallelSCCs(graph, component, threads);
+}
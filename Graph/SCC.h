@@ -0,0 +1,44 @@
+/*
+* SCC.h
+*/
+#ifndef SCC_H_
+#define SCC_H_
+
+#include <vector>
+#include "CSRGraph.h"
+#include "CompressedCSRGraph.h"
+#include "KindFilter.h"
+
+// Finds the strongly connected components of a frozen graph with an
+// iterative Tarjan search, so deep graphs cannot overflow the call stack.
+// component[v] receives the component of node v. Components are numbered
+// in reverse topological order of the condensation: every edge between
+// two components goes from a higher id to a lower one.
+// Returns the number of components.
+// Both kinds of frozen graph are accepted, here and below, and so are
+// KindFilter views of them, whose components only follow the edges kept.
+NodeId findSCCs(const CSRGraph& graph, std::vector<NodeId>& component);
+NodeId findSCCs(const CompressedCSRGraph& graph,
+                std::vector<NodeId>& component);
+NodeId findSCCs(const KindFilter<CSRGraph>& graph,
+                std::vector<NodeId>& component);
+NodeId findSCCs(const KindFilter<CompressedCSRGraph>& graph,
+                std::vector<NodeId>& component);
+
+// Same partition as findSCCs, computed on several threads for very large
+// graphs: nodes without a live predecessor or successor are trimmed off
+// in parallel rounds, the component of a high-degree pivot is found by
+// parallel forward and backward searches, and the three sets left over
+// (reached forward only, backward only, neither) are searched by Tarjan
+// concurrently. Components are numbered in no particular order.
+// threads == 0 uses all cores.
+NodeId findSCCsParallel(const CSRGraph& graph, std::vector<NodeId>& component,
+                        unsigned threads = 0);
+NodeId findSCCsParallel(const CompressedCSRGraph& graph,
+                        std::vector<NodeId>& component, unsigned threads = 0);
+NodeId findSCCsParallel(const KindFilter<CSRGraph>& graph,
+                        std::vector<NodeId>& component, unsigned threads = 0);
+NodeId findSCCsParallel(const KindFilter<CompressedCSRGraph>& graph,
+                        std::vector<NodeId>& component, unsigned threads = 0);
+
+#endif
@@ -0,0 +1,101 @@
+/*
+* Slab.h
+* ------
+* Fixed-size object pool. Objects are carved out of large blocks, freed
+* slots are kept on a free list for reuse, and all blocks are returned
+* to the system at once when the Slab is destroyed.
+*/
+#ifndef SLAB_H_
+#define SLAB_H_
+
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+template <class T>
+class Slab {
+private:
+    union Slot {
+        Slot* next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    static const std::size_t FIRST_BLOCK = 64;
+    static const std::size_t MAX_BLOCK = 65536;
+
+    std::vector<Slot*> blocks;
+    Slot* freeList;
+    std::size_t blockSlots;     // size of the newest block
+    std::size_t blockUsed;      // slots handed out of the newest block
+    std::size_t live;
+    std::size_t reserved;
+
+    // disallow copies; a Slab owns its blocks
+    Slab(const Slab&);
+    Slab& operator=(const Slab&);
+
+public:
+    Slab()
+        : freeList(NULL), blockSlots(0), blockUsed(0), live(0), reserved(0) {}
+
+    ~Slab()
+    {
+        for (std::size_t i = 0; i < blocks.size(); i++)
+        {
+            std::free(blocks[i]);
+        }
+    }
+
+    // returns uninitialized storage for one T; construct it with
+    // placement new
+    void*
+    allocate()
+    {
+        live++;
+        if (freeList != NULL)
+        {
+            Slot* slot = freeList;
+            freeList = slot->next;
+            return slot->storage;
+        }
+        if (blockUsed == blockSlots)
+        {
+            blockSlots = blockSlots == 0 ? FIRST_BLOCK
+                       : (blockSlots < MAX_BLOCK ? 2 * blockSlots : MAX_BLOCK);
+            Slot* block = (Slot*) std::malloc(blockSlots * sizeof(Slot));
+            if (block == NULL)
+            {
+                throw std::bad_alloc();
+            }
+            blocks.push_back(block);
+            blockUsed = 0;
+            reserved += blockSlots;
+        }
+        return blocks.back()[blockUsed++].storage;
+    }
+
+    // puts the slot of an already destroyed object back on the free list
+    void
+    release(T* object)
+    {
+        Slot* slot = reinterpret_cast<Slot*>(object);
+        slot->next = freeList;
+        freeList = slot;
+        live--;
+    }
+
+    // number of objects currently allocated
+    std::size_t
+    liveCount() const
+    {
+        return live;
+    }
+
+    // bytes held in blocks, used or not
+    std::size_t
+    bytesReserved() const
+    {
+        return reserved * sizeof(Slot);
+    }
+};
+#endif
@@ -0,0 +1,217 @@
+/*
+* Steensgaard.cpp
+*/
+#include "Steensgaard.h"
+#include <chrono>
+
+//===-----------------------------------------------------------------===//
+////////////////////////  SteensgaardSolver Class  ////////////////////////
+//===-----------------------------------------------------------------===//
+
+SteensgaardSolver::SteensgaardSolver(Graph& graph) : graph(graph)
+{
+}
+
+NodeId
+SteensgaardSolver::newClass()
+{
+    pointee.push_back(INVALID_NODE);
+    return classes.makeSet();
+}
+
+// the class of a graph node; ids merged away by an earlier solve() map
+// to the class of the node they live in
+NodeId
+SteensgaardSolver::classOfNode(NodeId var)
+{
+    if (classOf.size() < graph.numNodeIds())
+    {
+        classOf.resize(graph.numNodeIds(), INVALID_NODE);
+    }
+    if (classOf[var] == INVALID_NODE)
+    {
+        classOf[var] = newClass();
+    }
+    return classes.find(classOf[var]);
+}
+
+// the class cls points to, created empty if it points nowhere yet
+NodeId
+SteensgaardSolver::deref(NodeId cls)
+{
+    cls = classes.find(cls);
+    if (pointee[cls] == INVALID_NODE)
+    {
+        NodeId target = newClass();
+        pointee[cls] = target;
+        return target;
+    }
+    return classes.find(pointee[cls]);
+}
+
+// unites two classes, and then their pointees, and so on down
+void
+SteensgaardSolver::join(NodeId a, NodeId b)
+{
+    pendingJoins.push_back(std::make_pair(a, b));
+    while (!pendingJoins.empty())
+    {
+        NodeId x = classes.find(pendingJoins.back().first);
+        NodeId y = classes.find(pendingJoins.back().second);
+        pendingJoins.pop_back();
+        if (x == y)
+        {
+            continue;
+        }
+        NodeId px = pointee[x];
+        NodeId py = pointee[y];
+        NodeId root = classes.unite(x, y);
+        stats.joins++;
+        if (px == INVALID_NODE)
+        {
+            pointee[root] = py;
+        }
+        else
+        {
+            pointee[root] = px;
+            if (py != INVALID_NODE)
+            {
+                pendingJoins.push_back(std::make_pair(px, py));
+            }
+        }
+    }
+}
+
+void
+SteensgaardSolver::addConstraint(ConstraintKind kind, std::string_view dst,
+                                 std::string_view src)
+{
+    NodeId dstId = graph.internLabel(dst);
+    NodeId srcId = graph.internLabel(src);
+    addConstraint(kind, dstId, srcId);
+}
+
+void
+SteensgaardSolver::addConstraint(ConstraintKind kind, NodeId dst, NodeId src)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    dst = graph.resolve(dst);
+    src = graph.resolve(src);
+    if (dst == INVALID_NODE || src == INVALID_NODE)
+    {
+        return;
+    }
+    NodeId d = classOfNode(dst);
+    NodeId s = classOfNode(src);
+    switch (kind)
+    {
+        case ADDRESS_OF:
+            join(deref(d), s);
+            break;
+        case COPY:
+            join(deref(d), deref(s));
+            break;
+        case LOAD:
+            join(deref(d), deref(deref(s)));
+            break;
+        case STORE:
+            join(deref(deref(d)), deref(s));
+            break;
+    }
+    stats.constraints++;
+    stats.seconds += std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+// the nodes of a class are merged into the one with the most edges, so
+// the fewest edges have to be rewired
+void
+SteensgaardSolver::solve()
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    leader.assign(classes.size(), INVALID_NODE);
+
+    NodeId v;
+    NodeId limit = (NodeId) std::min<std::size_t>(classOf.size(), graph.numNodeIds());
+    for (v = 0; v < limit; v++)
+    {
+        Node* node = graph.getNodeById(v);
+        if (node == NULL || classOf[v] == INVALID_NODE)
+        {
+            continue;
+        }
+        NodeId& best = leader[classes.find(classOf[v])];
+        if (best == INVALID_NODE)
+        {
+            best = v;
+            continue;
+        }
+        Node* bestNode = graph.getNodeById(best);
+        if (node->getOutEdges()->size() + node->getInEdges()->size()
+            > bestNode->getOutEdges()->size() + bestNode->getInEdges()->size())
+        {
+            best = v;
+        }
+    }
+
+    for (v = 0; v < limit; v++)
+    {
+        Node* node = graph.getNodeById(v);
+        if (node == NULL || classOf[v] == INVALID_NODE)
+        {
+            continue;
+        }
+        NodeId best = leader[classes.find(classOf[v])];
+        if (best != v)
+        {
+            graph.merge(graph.getNodeById(best), node);
+            stats.nodesMerged++;
+        }
+    }
+
+    NodeId cls;
+    for (cls = 0; cls < leader.size(); cls++)
+    {
+        if (leader[cls] == INVALID_NODE || pointee[cls] == INVALID_NODE)
+        {
+            continue;
+        }
+        NodeId target = leader[classes.find(pointee[cls])];
+        if (target != INVALID_NODE)
+        {
+            graph.createEdge(graph.getNodeById(leader[cls]),
+                             graph.getNodeById(target));
+        }
+    }
+    stats.seconds += std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+NodeId
+SteensgaardSolver::pointsTo(NodeId var)
+{
+    var = graph.resolve(var);
+    if (var == INVALID_NODE || var >= classOf.size()
+        || classOf[var] == INVALID_NODE)
+    {
+        return INVALID_NODE;
+    }
+    NodeId target = pointee[classes.find(classOf[var])];
+    if (target == INVALID_NODE)
+    {
+        return INVALID_NODE;
+    }
+    target = classes.find(target);
+    return target < leader.size() ? graph.resolve(leader[target]) : INVALID_NODE;
+}
+
+NodeId
+SteensgaardSolver::pointsTo(std::string_view label)
+{
+    NodeId var = graph.getIdAtLabel(label);
+    if (var == INVALID_NODE)
+    {
+        return INVALID_NODE;
+    }
+    return pointsTo(var);
+}
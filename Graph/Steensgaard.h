@@ -0,0 +1,93 @@
+/*
+* Steensgaard.h
+*/
+#ifndef STEENSGAARD_H_
+#define STEENSGAARD_H_
+
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "Graph.h"
+#include "UnionFind.h"
+
+/////////////////    SteensgaardSolver Class   //////////////////////
+
+// Unification-based (Steensgaard-style) points-to analysis on top of a
+// Graph. Constraints are consumed as they arrive: every variable has an
+// equivalence class, every class points to at most one other class, and
+// a constraint joins classes with a union-find instead of touching the
+// graph. Joins that a join implies (the pointees of two joined classes)
+// go on a worklist rather than recursing, so a stream of m constraints
+// costs O(m alpha(m)).
+//
+// solve() then writes the result into the graph: the nodes of each class
+// are merged (Graph::merge) and each class gets a single edge to the
+// class it points to, the shape unionize() maintains.
+class SteensgaardSolver {
+    public:
+        enum ConstraintKind {
+            ADDRESS_OF,     // dst = &src
+            COPY,           // dst = src
+            LOAD,           // dst = *src
+            STORE           // *dst = src
+        };
+
+        struct Stats {
+            std::size_t constraints;
+            std::size_t joins;            // classes united
+            std::size_t nodesMerged;      // graph nodes merged by solve()
+            double seconds;               // time spent on constraints and solve()
+
+            Stats()
+                : constraints(0), joins(0), nodesMerged(0), seconds(0) {}
+
+            double constraintsPerSecond() const {
+                return seconds > 0 ? constraints / seconds : 0;
+            }
+        };
+
+    private:
+        Graph& graph;
+
+        // graph node id -> its class, INVALID_NODE until first used.
+        // Classes are also made for pointees nothing names yet
+        std::vector<NodeId> classOf;
+        UnionFind classes;
+        std::vector<NodeId> pointee;        // class -> class, by root
+
+        // class root -> the graph node holding it after the last solve()
+        std::vector<NodeId> leader;
+
+        std::vector<std::pair<NodeId, NodeId> > pendingJoins;
+
+        Stats stats;
+
+        NodeId newClass();
+        NodeId classOfNode(NodeId var);
+        NodeId deref(NodeId cls);
+        void join(NodeId a, NodeId b);
+
+    public:
+        explicit SteensgaardSolver(Graph& graph);
+
+        // unifies according to one constraint; labels are turned into
+        // nodes on demand
+        void addConstraint(ConstraintKind kind, std::string_view dst,
+                           std::string_view src);
+        void addConstraint(ConstraintKind kind, NodeId dst, NodeId src);
+
+        // merges the nodes of each class and adds the points-to edges.
+        // May be called again after more constraints arrive
+        void solve();
+
+        // after solve(), the id of the node the variable's class points
+        // to, or INVALID_NODE
+        NodeId pointsTo(NodeId var);
+        NodeId pointsTo(std::string_view label);
+
+        const Stats& getStats() const {
+            return stats;
+        }
+};
+
+#endif
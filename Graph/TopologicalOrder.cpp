@@ -0,0 +1,244 @@
+/*
+* TopologicalOrder.cpp
+*/
+#include "TopologicalOrder.h"
+#include "Node.h"
+#include "Edge.h"
+#include <algorithm>
+
+//===-----------------------------------------------------------------===//
+///////////////////////  TopologicalOrder Class  //////////////////////////
+//===-----------------------------------------------------------------===//
+
+// Kahn's algorithm
+bool
+TopologicalOrder::build(const std::vector<Node*>& nodes)
+{
+    std::size_t n = nodes.size();
+    position.assign(n, INVALID_NODE);
+    order.clear();
+    visited.assign(n, 0);
+
+    std::vector<std::size_t> pending(n, 0);
+    std::vector<NodeId> ready;
+    std::size_t live = 0;
+    std::size_t i;
+    for (i = 0; i < n; i++)
+    {
+        if (nodes[i] == NULL)
+        {
+            continue;
+        }
+        live++;
+        pending[i] = nodes[i]->getInEdges()->size();
+        if (pending[i] == 0)
+        {
+            ready.push_back((NodeId) i);
+        }
+    }
+
+    // first in, first out, so unrelated nodes keep their id order
+    for (std::size_t head = 0; head < ready.size(); head++)
+    {
+        NodeId v = ready[head];
+        position[v] = (NodeId) order.size();
+        order.push_back(v);
+        std::vector<Edge*>* outEdges = nodes[v]->getOutEdges();
+        for (i = 0; i < outEdges->size(); i++)
+        {
+            NodeId w = (*outEdges)[i]->getTarget()->getId();
+            if (--pending[w] == 0)
+            {
+                ready.push_back(w);
+            }
+        }
+    }
+    return order.size() == live;
+}
+
+void
+TopologicalOrder::addNode(NodeId id)
+{
+    if (position.size() <= id)
+    {
+        position.resize(id + 1, INVALID_NODE);
+        visited.resize(id + 1, 0);
+    }
+    position[id] = (NodeId) order.size();
+    order.push_back(id);
+}
+
+void
+TopologicalOrder::removeNode(NodeId id)
+{
+    order[position[id]] = INVALID_NODE;
+    position[id] = INVALID_NODE;
+}
+
+// collects into `forward` the nodes reachable from `from` whose position
+// is below `upper`. Returns false as soon as it meets `stop`
+bool
+TopologicalOrder::searchForward(Node* from, Node* stop, NodeId upper)
+{
+    stack.push_back(from);
+    visited[from->getId()] = 1;
+    while (!stack.empty())
+    {
+        Node* v = stack.back();
+        stack.pop_back();
+        forward.push_back(v);
+        std::vector<Edge*>* outEdges = v->getOutEdges();
+        for (std::size_t i = 0; i < outEdges->size(); i++)
+        {
+            Node* w = (*outEdges)[i]->getTarget();
+            if (w == stop)
+            {
+                // hand the unexplored nodes over too, so their marks
+                // are cleared with the rest
+                forward.insert(forward.end(), stack.begin(), stack.end());
+                stack.clear();
+                return false;
+            }
+            NodeId id = w->getId();
+            if (!visited[id] && position[id] < upper)
+            {
+                visited[id] = 1;
+                stack.push_back(w);
+            }
+        }
+    }
+    return true;
+}
+
+// collects into `backward` the nodes that reach `from` whose position is
+// above `lower`
+void
+TopologicalOrder::searchBackward(Node* from, NodeId lower)
+{
+    stack.push_back(from);
+    visited[from->getId()] = 1;
+    while (!stack.empty())
+    {
+        Node* v = stack.back();
+        stack.pop_back();
+        backward.push_back(v);
+        std::vector<Edge*>* inEdges = v->getInEdges();
+        for (std::size_t i = 0; i < inEdges->size(); i++)
+        {
+            Node* w = (*inEdges)[i]->getSource();
+            NodeId id = w->getId();
+            if (!visited[id] && position[id] > lower)
+            {
+                visited[id] = 1;
+                stack.push_back(w);
+            }
+        }
+    }
+}
+
+// the backward set goes before the forward set, each keeping its own
+// relative order, in the positions the two sets held between them
+void
+TopologicalOrder::reorder()
+{
+    struct ByPosition {
+        const std::vector<NodeId>& position;
+        bool operator()(Node* a, Node* b) const {
+            return position[a->getId()] < position[b->getId()];
+        }
+    } byPosition = { position };
+    std::sort(backward.begin(), backward.end(), byPosition);
+    std::sort(forward.begin(), forward.end(), byPosition);
+
+    std::vector<NodeId> slots;
+    slots.reserve(backward.size() + forward.size());
+    std::size_t i;
+    for (i = 0; i < backward.size(); i++)
+    {
+        slots.push_back(position[backward[i]->getId()]);
+    }
+    for (i = 0; i < forward.size(); i++)
+    {
+        slots.push_back(position[forward[i]->getId()]);
+    }
+    std::sort(slots.begin(), slots.end());
+
+    std::size_t next = 0;
+    for (i = 0; i < backward.size(); i++, next++)
+    {
+        position[backward[i]->getId()] = slots[next];
+        order[slots[next]] = backward[i]->getId();
+    }
+    for (i = 0; i < forward.size(); i++, next++)
+    {
+        position[forward[i]->getId()] = slots[next];
+        order[slots[next]] = forward[i]->getId();
+    }
+}
+
+bool
+TopologicalOrder::insertEdge(Node* source, Node* target)
+{
+    if (source == target)
+    {
+        return false;
+    }
+    NodeId lower = position[target->getId()];
+    NodeId upper = position[source->getId()];
+    if (upper < lower)
+    {
+        return true;
+    }
+
+    bool acyclic = searchForward(target, source, upper);
+    if (acyclic)
+    {
+        searchBackward(source, lower);
+        reorder();
+    }
+    clearSearch();
+    return acyclic;
+}
+
+void
+TopologicalOrder::clearSearch()
+{
+    std::size_t i;
+    for (i = 0; i < forward.size(); i++)
+    {
+        visited[forward[i]->getId()] = 0;
+    }
+    for (i = 0; i < backward.size(); i++)
+    {
+        visited[backward[i]->getId()] = 0;
+    }
+    forward.clear();
+    backward.clear();
+}
+
+// a path can only lead from the earlier node to the later one
+bool
+TopologicalOrder::connected(Node* a, Node* b)
+{
+    if (position[a->getId()] > position[b->getId()])
+    {
+        std::swap(a, b);
+    }
+    bool apart = searchForward(a, b, position[b->getId()]);
+    clearSearch();
+    return !apart;
+}
+
+std::vector<NodeId>
+TopologicalOrder::nodes() const
+{
+    std::vector<NodeId> result;
+    for (std::size_t i = 0; i < order.size(); i++)
+    {
+        if (order[i] != INVALID_NODE)
+        {
+            result.push_back(order[i]);
+        }
+    }
+    return result;
+}
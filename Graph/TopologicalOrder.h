@@ -0,0 +1,73 @@
+/*
+* TopologicalOrder.h
+*/
+#ifndef TOPOLOGICALORDER_H_
+#define TOPOLOGICALORDER_H_
+
+#include <vector>
+#include "GraphTypes.h"
+
+class Node;
+
+/////////////////    TopologicalOrder Class   //////////////////////
+
+// A topological order of a Graph kept up to date edge by edge with the
+// Pearce-Kelly algorithm. Every node has a distinct position and every
+// edge goes from a lower position to a higher one. Inserting an edge
+// that already agrees with the order costs O(1); otherwise only the
+// nodes between its endpoints' positions that are reachable from the
+// target (forward) or reach the source (backward) are visited and
+// shuffled among their own positions. A forward search that meets the
+// source means the edge would close a cycle, and it is refused.
+// Graph drives this class; see Graph::maintainTopologicalOrder.
+class TopologicalOrder {
+    private:
+        // node id -> position, and position -> node id (INVALID_NODE
+        // where a removed node was)
+        std::vector<NodeId> position;
+        std::vector<NodeId> order;
+
+        // scratch for insertEdge, indexed by node id
+        std::vector<char> visited;
+        std::vector<Node*> stack;
+        std::vector<Node*> forward;
+        std::vector<Node*> backward;
+
+        bool searchForward(Node* from, Node* stop, NodeId upper);
+        void searchBackward(Node* from, NodeId lower);
+        void reorder();
+
+        // clears the marks left by a search and empties its sets
+        void clearSearch();
+
+    public:
+        TopologicalOrder() {}
+
+        // orders the given nodes (indexed by id, NULL slots skipped) from
+        // scratch. Returns false if they contain a cycle
+        bool build(const std::vector<Node*>& nodes);
+
+        // gives a new node (the highest id so far) the last position
+        void addNode(NodeId id);
+
+        // forgets a node; the order of the others stays valid
+        void removeNode(NodeId id);
+
+        // given an edge about to be added, moves nodes so it fits the
+        // order. Returns false, leaving the order as it was, if the edge
+        // would close a cycle
+        bool insertEdge(Node* source, Node* target);
+
+        // returns true if there is a path between the two nodes, either
+        // way. Only the nodes between their positions are searched
+        bool connected(Node* a, Node* b);
+
+        NodeId positionOf(NodeId id) const {
+            return position[id];
+        }
+
+        // the live node ids in topological order
+        std::vector<NodeId> nodes() const;
+};
+
+#endif
@@ -0,0 +1,60 @@
+/*
+* UnionFind.cpp
+*/
+#include "UnionFind.h"
+
+//===-----------------------------------------------------------------===//
+////////////////////////////  UnionFind Class  ////////////////////////////
+//===-----------------------------------------------------------------===//
+
+NodeId
+UnionFind::makeSet()
+{
+    NodeId id = (NodeId) parent.size();
+    parent.push_back(id);
+    rank.push_back(0);
+    return id;
+}
+
+NodeId
+UnionFind::find(NodeId x)
+{
+    while (parent[x] != x)
+    {
+        parent[x] = parent[parent[x]];     // path halving
+        x = parent[x];
+    }
+    return x;
+}
+
+NodeId
+UnionFind::peek(NodeId x) const
+{
+    while (parent[x] != x)
+    {
+        x = parent[x];
+    }
+    return x;
+}
+
+NodeId
+UnionFind::unite(NodeId a, NodeId b)
+{
+    a = find(a);
+    b = find(b);
+    if (a == b)
+    {
+        return a;
+    }
+    if (rank[a] < rank[b])
+    {
+        parent[a] = b;
+        return b;
+    }
+    parent[b] = a;
+    if (rank[a] == rank[b])
+    {
+        rank[a]++;
+    }
+    return a;
+}
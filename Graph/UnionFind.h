@@ -0,0 +1,51 @@
+/*
+* UnionFind.h
+*/
+#ifndef UNIONFIND_H_
+#define UNIONFIND_H_
+
+#include <vector>
+#include "GraphTypes.h"
+
+/////////////////    UnionFind Class   //////////////////////
+
+// Disjoint-set forest over dense ids with path halving and union by rank.
+// Graph uses it to resolve a label to the node its class was merged into.
+class UnionFind {
+    private:
+        std::vector<NodeId> parent;
+        std::vector<unsigned char> rank;
+
+    public:
+        UnionFind() {}
+
+        // adds a new singleton set and returns its id
+        NodeId makeSet();
+
+        // returns the representative of the set containing x
+        NodeId find(NodeId x);
+
+        // like find, but without shortening paths, so several threads can
+        // call it at once as long as nothing unites meanwhile
+        NodeId peek(NodeId x) const;
+
+        // joins the sets containing a and b and returns the new root
+        NodeId unite(NodeId a, NodeId b);
+
+        std::size_t size() const {
+            return parent.size();
+        }
+
+        // makes room for n sets in total, so makeSet does not move the
+        // storage other threads are reading
+        void reserve(std::size_t n) {
+            parent.reserve(n);
+            rank.reserve(n);
+        }
+
+        std::size_t capacity() const {
+            return parent.capacity();
+        }
+};
+
+#endif
@@ -0,0 +1,128 @@
+/*
+* Generators.cpp
+*/
+#include "Generators.h"
+#include <algorithm>
+
+//===-----------------------------------------------------------------===//
+// Synthetic workloads
+//===-----------------------------------------------------------------===//
+
+EdgeList
+rmatEdges(unsigned scale, unsigned edgeFactor, uint64_t seed,
+          double a, double b, double c)
+{
+    BenchRandom random(seed);
+    NodeId n = (NodeId) 1 << scale;
+    std::size_t m = (std::size_t) edgeFactor << scale;
+    EdgeList edges;
+    edges.reserve(m);
+    for (std::size_t i = 0; i < m; i++)
+    {
+        NodeId source = 0;
+        NodeId target = 0;
+        for (unsigned bit = 0; bit < scale; bit++)
+        {
+            double p = random.unit();
+            if (p >= a + b + c)
+            {
+                source |= (NodeId) 1 << bit;
+                target |= (NodeId) 1 << bit;
+            }
+            else if (p >= a + b)
+            {
+                source |= (NodeId) 1 << bit;
+            }
+            else if (p >= a)
+            {
+                target |= (NodeId) 1 << bit;
+            }
+        }
+        edges.push_back(std::make_pair(source, target));
+    }
+
+    std::vector<NodeId> shuffle(n);
+    NodeId v;
+    for (v = 0; v < n; v++)
+    {
+        shuffle[v] = v;
+    }
+    for (v = n - 1; v > 0; v--)
+    {
+        std::swap(shuffle[v], shuffle[random.below((uint64_t) v + 1)]);
+    }
+    for (std::size_t i = 0; i < m; i++)
+    {
+        edges[i].first = shuffle[edges[i].first];
+        edges[i].second = shuffle[edges[i].second];
+    }
+    return edges;
+}
+
+EdgeList
+chainEdges(NodeId n)
+{
+    EdgeList edges;
+    for (NodeId v = 0; v + 1 < n; v++)
+    {
+        edges.push_back(std::make_pair(v, v + 1));
+    }
+    return edges;
+}
+
+EdgeList
+starEdges(NodeId n)
+{
+    EdgeList edges;
+    for (NodeId v = 1; v < n; v++)
+    {
+        edges.push_back(std::make_pair((NodeId) 0, v));
+    }
+    return edges;
+}
+
+EdgeList
+cliqueEdges(NodeId n)
+{
+    EdgeList edges;
+    edges.reserve((std::size_t) n * (n > 0 ? n - 1 : 0));
+    for (NodeId u = 0; u < n; u++)
+    {
+        for (NodeId v = 0; v < n; v++)
+        {
+            if (u != v)
+            {
+                edges.push_back(std::make_pair(u, v));
+            }
+        }
+    }
+    return edges;
+}
+
+EdgeList
+unificationPairs(const EdgeList& edges, std::size_t count, uint64_t seed)
+{
+    BenchRandom random(seed);
+    EdgeList pairs;
+    if (edges.empty())
+    {
+        return pairs;
+    }
+    pairs.reserve(count);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        pairs.push_back(edges[random.below(edges.size())]);
+    }
+    return pairs;
+}
+
+NodeId
+nodeCount(const EdgeList& edges)
+{
+    NodeId n = 0;
+    for (std::size_t i = 0; i < edges.size(); i++)
+    {
+        n = std::max(n, std::max(edges[i].first, edges[i].second) + 1);
+    }
+    return n;
+}
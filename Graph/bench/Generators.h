@@ -0,0 +1,73 @@
+/*
+* Generators.h
+*/
+#ifndef GENERATORS_H_
+#define GENERATORS_H_
+
+#include <stdint.h>
+#include <utility>
+#include <vector>
+#include "GraphTypes.h"
+
+typedef std::vector<std::pair<NodeId, NodeId> > EdgeList;
+
+/////////////////    BenchRandom Class   //////////////////////
+
+// Small, fast and reproducible generator (splitmix64), so workloads are
+// the same on every platform for a given seed.
+class BenchRandom {
+    private:
+        uint64_t state;
+
+    public:
+        explicit BenchRandom(uint64_t seed) : state(seed) {}
+
+        uint64_t next() {
+            uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            return z ^ (z >> 31);
+        }
+
+        // uniform in [0, bound)
+        uint64_t below(uint64_t bound) {
+            return next() % bound;
+        }
+
+        // uniform in [0, 1)
+        double unit() {
+            return (next() >> 11) * (1.0 / 9007199254740992.0);
+        }
+};
+
+// Synthetic edge lists over nodes 0 .. n-1. Lists may hold duplicate
+// edges and self-loops where the model produces them; Graph drops the
+// duplicates on insertion.
+
+// R-MAT (Chakrabarti, Zhan and Faloutsos): 2^scale nodes and
+// edgeFactor * 2^scale edges. Every edge descends the adjacency matrix
+// one bit at a time, picking a quadrant with probabilities a, b, c and
+// 1 - a - b - c, which gives the skewed, power-law degrees of real
+// graphs. Node ids are shuffled afterwards so that hubs are not all
+// near id 0. The defaults are those of Graph500
+EdgeList rmatEdges(unsigned scale, unsigned edgeFactor, uint64_t seed,
+                   double a = 0.57, double b = 0.19, double c = 0.19);
+
+// 0 -> 1 -> ... -> n-1
+EdgeList chainEdges(NodeId n);
+
+// a hub (node 0) with an edge to each of the other n - 1 nodes
+EdgeList starEdges(NodeId n);
+
+// every ordered pair of distinct nodes among n
+EdgeList cliqueEdges(NodeId n);
+
+// count pairs of nodes to unify, drawn from the given edges the way a
+// unification-based analysis merges the two ends of an assignment
+EdgeList unificationPairs(const EdgeList& edges, std::size_t count,
+                          uint64_t seed);
+
+// largest node id in the list plus one
+NodeId nodeCount(const EdgeList& edges);
+
+#endif
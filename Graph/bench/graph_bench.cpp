@@ -0,0 +1,592 @@
+/*
+* graph_bench.cpp
+*
+* Benchmarks Graph operations over synthetic workloads (see Generators.h)
+* and prints one JSON document with, for every benchmark, the number of
+* operations, throughput, latency percentiles and peak resident memory.
+*
+*   graph_bench [--scale S] [--edge-factor F] [--seed N] [--reps R]
+*               [--filter TEXT] [--out FILE] [--dot-dir DIR]
+*
+* --scale sets the size of every workload (2^S nodes, F * 2^S R-MAT
+* edges); --filter runs only the benchmarks whose "name/workload"
+* contains TEXT. Progress goes to stderr.
+*/
+#include "Graph.h"
+#include "Generators.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+
+typedef std::chrono::steady_clock Clock;
+
+struct BenchConfig {
+    unsigned scale;
+    unsigned edgeFactor;
+    uint64_t seed;
+    unsigned reps;
+    std::string filter;
+    std::string out;
+    std::string dotDir;
+
+    BenchConfig()
+        : scale(16), edgeFactor(16), seed(1), reps(5), dotDir("/tmp") {}
+};
+
+struct BenchResult {
+    std::string name;
+    std::string workload;
+    std::size_t nodes;
+    std::size_t edges;
+    uint64_t ops;
+    double seconds;
+    std::vector<uint64_t> latencies;    // sampled, in nanoseconds
+    long peakRssKb;
+
+    BenchResult() : nodes(0), edges(0), ops(0), seconds(0), peakRssKb(0) {}
+};
+
+// at most this many latencies are kept per benchmark; longer runs time
+// every k-th operation only
+static const std::size_t MAX_SAMPLES = 1 << 20;
+
+static uint64_t
+nanosSince(Clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now() - start).count();
+}
+
+//===-----------------------------------------------------------------===//
+// Peak RSS
+//
+// Writing "5" to /proc/self/clear_refs resets the high-water mark on
+// Linux, so each benchmark reports its own peak. Where that fails the
+// figure is the peak of the whole run so far, from getrusage.
+
+static void
+resetPeakRss()
+{
+    FILE* file = std::fopen("/proc/self/clear_refs", "w");
+    if (file != NULL)
+    {
+        std::fputs("5", file);
+        std::fclose(file);
+    }
+}
+
+static long
+peakRssKb()
+{
+    FILE* file = std::fopen("/proc/self/status", "r");
+    if (file != NULL)
+    {
+        char line[256];
+        long kb = -1;
+        while (std::fgets(line, sizeof(line), file) != NULL)
+        {
+            if (std::strncmp(line, "VmHWM:", 6) == 0)
+            {
+                kb = std::atol(line + 6);
+                break;
+            }
+        }
+        std::fclose(file);
+        if (kb >= 0)
+        {
+            return kb;
+        }
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+//===-----------------------------------------------------------------===//
+// Timing
+
+// runs op(0) .. op(count - 1), timing the whole loop and sampling the
+// latency of single operations
+template <class Op>
+static void
+timeOps(BenchResult& result, std::size_t count, Op op)
+{
+    std::size_t stride = count / MAX_SAMPLES + 1;
+    result.latencies.reserve(result.latencies.size() + count / stride + 1);
+    Clock::time_point start = Clock::now();
+    for (std::size_t i = 0; i < count; i++)
+    {
+        if (i % stride == 0)
+        {
+            Clock::time_point before = Clock::now();
+            op(i);
+            result.latencies.push_back(nanosSince(before));
+        }
+        else
+        {
+            op(i);
+        }
+    }
+    result.seconds += std::chrono::duration<double>(Clock::now() - start)
+                          .count();
+    result.ops += count;
+}
+
+// runs one bulk operation, counted as a single op
+template <class Op>
+static void
+timeOnce(BenchResult& result, Op op)
+{
+    Clock::time_point start = Clock::now();
+    op();
+    uint64_t elapsed = nanosSince(start);
+    result.latencies.push_back(elapsed);
+    result.seconds += elapsed * 1e-9;
+    result.ops++;
+}
+
+//===-----------------------------------------------------------------===//
+// Workloads
+
+static std::vector<std::string>
+makeLabels(NodeId n, const char* prefix)
+{
+    std::vector<std::string> labels(n);
+    char buffer[32];
+    for (NodeId v = 0; v < n; v++)
+    {
+        std::snprintf(buffer, sizeof(buffer), "%s%u", prefix, v);
+        labels[v] = buffer;
+    }
+    return labels;
+}
+
+static EdgeList
+workloadEdges(const BenchConfig& config, const std::string& workload)
+{
+    NodeId n = (NodeId) 1 << config.scale;
+    if (workload == "chain")
+    {
+        return chainEdges(n);
+    }
+    if (workload == "star")
+    {
+        return starEdges(n);
+    }
+    if (workload == "clique")
+    {
+        // about a million edges at the default scale
+        NodeId k = (NodeId) 1 << std::min((config.scale + 4) / 2, 11u);
+        return cliqueEdges(k);
+    }
+    return rmatEdges(config.scale, config.edgeFactor, config.seed);
+}
+
+// makes one node per label, in id order, so graph ids match workload ids
+static std::vector<Node*>
+makeAllNodes(Graph& graph, const std::vector<std::string>& labels)
+{
+    std::vector<Node*> nodes(labels.size());
+    for (std::size_t v = 0; v < labels.size(); v++)
+    {
+        nodes[v] = graph.makeNode(labels[v]);
+    }
+    return nodes;
+}
+
+//===-----------------------------------------------------------------===//
+// Benchmarks
+
+static void
+benchMakeNodes(const EdgeList& edges, const std::vector<std::string>& labels,
+               BenchResult& result)
+{
+    Graph graph;
+    timeOps(result, edges.size(), [&](std::size_t i)
+        {
+            graph.makeNodes(labels[edges[i].first], labels[edges[i].second]);
+        });
+}
+
+static void
+benchCreateEdge(const EdgeList& edges, const std::vector<std::string>& labels,
+                BenchResult& result)
+{
+    Graph graph;
+    std::vector<Node*> nodes = makeAllNodes(graph, labels);
+    timeOps(result, edges.size(), [&](std::size_t i)
+        {
+            graph.createEdge(nodes[edges[i].first], nodes[edges[i].second]);
+        });
+}
+
+static void
+benchAddEdgesById(const BenchConfig& config, const EdgeList& edges,
+                  const std::vector<std::string>& labels, BenchResult& result)
+{
+    for (unsigned rep = 0; rep < config.reps; rep++)
+    {
+        Graph graph;
+        makeAllNodes(graph, labels);
+        timeOnce(result, [&]() { graph.addEdgesById(edges); });
+    }
+}
+
+static void
+benchGetNodeAtLabel(const BenchConfig& config, const EdgeList& edges,
+                    const std::vector<std::string>& labels,
+                    BenchResult& result)
+{
+    Graph graph;
+    makeAllNodes(graph, labels);
+    graph.addEdgesById(edges);
+    BenchRandom random(config.seed + 1);
+    std::vector<NodeId> order(edges.size());
+    for (std::size_t i = 0; i < order.size(); i++)
+    {
+        order[i] = (NodeId) random.below(labels.size());
+    }
+    std::size_t found = 0;
+    timeOps(result, order.size(), [&](std::size_t i)
+        {
+            found += graph.getNodeAtLabel(labels[order[i]]) != NULL;
+        });
+    if (found != order.size())
+    {
+        std::fprintf(stderr, "getNodeAtLabel: %zu labels missing\n",
+                     order.size() - found);
+    }
+}
+
+// merges the two ends of random edges, looking both up by label the way
+// a unification-based analysis does. As in condense() and the
+// Steensgaard solver, the node with fewer edges is folded into the other
+// one. Pairs already unified cost only the lookups
+static void
+benchMerge(const BenchConfig& config, const EdgeList& edges,
+           const std::vector<std::string>& labels, BenchResult& result)
+{
+    Graph graph;
+    makeAllNodes(graph, labels);
+    graph.addEdgesById(edges);
+    EdgeList pairs = unificationPairs(edges, labels.size() / 2,
+                                      config.seed + 2);
+    timeOps(result, pairs.size(), [&](std::size_t i)
+        {
+            Node* a = graph.getNodeAtLabel(labels[pairs[i].first]);
+            Node* b = graph.getNodeAtLabel(labels[pairs[i].second]);
+            if (a == b)
+            {
+                return;
+            }
+            if (a->getOutEdges()->size() + a->getInEdges()->size()
+                < b->getOutEdges()->size() + b->getInEdges()->size())
+            {
+                std::swap(a, b);
+            }
+            graph.merge(a, b);
+        });
+}
+
+// removes a random half of the nodes
+static void
+benchRemoveNode(const BenchConfig& config, const EdgeList& edges,
+                const std::vector<std::string>& labels, BenchResult& result)
+{
+    Graph graph;
+    std::vector<Node*> nodes = makeAllNodes(graph, labels);
+    graph.addEdgesById(edges);
+    BenchRandom random(config.seed + 3);
+    for (std::size_t v = nodes.size(); v > 1; v--)
+    {
+        std::swap(nodes[v - 1], nodes[random.below(v)]);
+    }
+    timeOps(result, nodes.size() / 2, [&](std::size_t i)
+        {
+            graph.removeNode(nodes[i]);
+        });
+}
+
+static void
+benchCloneNode(const BenchConfig& config, const EdgeList& edges,
+               const std::vector<std::string>& labels, BenchResult& result)
+{
+    Graph graph;
+    makeAllNodes(graph, labels);
+    graph.addEdgesById(edges);
+    std::size_t count = std::min<std::size_t>(labels.size(), 1 << 16);
+    std::vector<std::string> clones = makeLabels((NodeId) count, "clone");
+    BenchRandom random(config.seed + 4);
+    std::vector<NodeId> originals(count);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        originals[i] = (NodeId) random.below(labels.size());
+    }
+    timeOps(result, count, [&](std::size_t i)
+        {
+            graph.cloneNode(clones[i], labels[originals[i]]);
+        });
+}
+
+// BFS and SCC over the frozen view; the view is built before timing
+static void
+benchTraversal(const BenchConfig& config, const std::string& name,
+               const EdgeList& edges, const std::vector<std::string>& labels,
+               BenchResult& result)
+{
+    Graph graph;
+    makeAllNodes(graph, labels);
+    graph.addEdgesById(edges);
+    graph.freeze();
+    BenchRandom random(config.seed + 5);
+    for (unsigned rep = 0; rep < config.reps; rep++)
+    {
+        if (name == "bfs")
+        {
+            std::vector<NodeId> roots(1, (NodeId) random.below(labels.size()));
+            std::vector<NodeId> distance;
+            timeOnce(result, [&]() { graph.distances(roots, distance); });
+        }
+        else
+        {
+            std::vector<NodeId> component;
+            timeOnce(result, [&]() { graph.findSCCs(component); });
+        }
+    }
+}
+
+static void
+benchCreateDotFile(const BenchConfig& config, const EdgeList& edges,
+                   const std::vector<std::string>& labels, BenchResult& result)
+{
+    Graph graph;
+    makeAllNodes(graph, labels);
+    graph.addEdgesById(edges);
+    graph.freeze();
+    std::string path = config.dotDir + "/graph_bench.dot";
+    for (unsigned rep = 0; rep < config.reps; rep++)
+    {
+        bool ok = true;
+        timeOnce(result, [&]() { ok = graph.createDotFile(path); });
+        if (!ok)
+        {
+            std::fprintf(stderr, "createDotFile: cannot write %s\n",
+                         path.c_str());
+            break;
+        }
+    }
+    std::remove(path.c_str());
+}
+
+//===-----------------------------------------------------------------===//
+// Report
+
+static uint64_t
+percentile(const std::vector<uint64_t>& sorted, double q)
+{
+    if (sorted.empty())
+    {
+        return 0;
+    }
+    std::size_t i = (std::size_t) (q * sorted.size());
+    return sorted[std::min(i, sorted.size() - 1)];
+}
+
+static void
+writeResult(FILE* out, BenchResult& result, bool first)
+{
+    std::sort(result.latencies.begin(), result.latencies.end());
+    const std::vector<uint64_t>& l = result.latencies;
+    std::fprintf(out,
+        "%s    {\"benchmark\": \"%s\", \"workload\": \"%s\", "
+        "\"nodes\": %zu, \"edges\": %zu, \"ops\": %llu, "
+        "\"seconds\": %.6f, \"opsPerSecond\": %.1f,\n"
+        "     \"latencyNs\": {\"samples\": %zu, \"p50\": %llu, "
+        "\"p90\": %llu, \"p99\": %llu, \"p999\": %llu, \"max\": %llu},\n"
+        "     \"peakRssKb\": %ld}",
+        first ? "" : ",\n", result.name.c_str(), result.workload.c_str(),
+        result.nodes, result.edges, (unsigned long long) result.ops,
+        result.seconds,
+        result.seconds > 0 ? result.ops / result.seconds : 0.0,
+        l.size(), (unsigned long long) percentile(l, 0.5),
+        (unsigned long long) percentile(l, 0.9),
+        (unsigned long long) percentile(l, 0.99),
+        (unsigned long long) percentile(l, 0.999),
+        (unsigned long long) (l.empty() ? 0 : l.back()),
+        result.peakRssKb);
+}
+
+//===-----------------------------------------------------------------===//
+// Driver
+
+static bool
+parseArgs(int argc, char** argv, BenchConfig& config)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            return false;
+        }
+        const char* value = argv[++i];
+        if (arg == "--scale")
+        {
+            config.scale = (unsigned) std::atoi(value);
+        }
+        else if (arg == "--edge-factor")
+        {
+            config.edgeFactor = (unsigned) std::atoi(value);
+        }
+        else if (arg == "--seed")
+        {
+            config.seed = std::strtoull(value, NULL, 10);
+        }
+        else if (arg == "--reps")
+        {
+            config.reps = (unsigned) std::atoi(value);
+        }
+        else if (arg == "--filter")
+        {
+            config.filter = value;
+        }
+        else if (arg == "--out")
+        {
+            config.out = value;
+        }
+        else if (arg == "--dot-dir")
+        {
+            config.dotDir = value;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return config.scale > 0 && config.scale < 31 && config.reps > 0;
+}
+
+int
+main(int argc, char** argv)
+{
+    BenchConfig config;
+    if (!parseArgs(argc, argv, config))
+    {
+        std::fprintf(stderr,
+            "usage: %s [--scale S] [--edge-factor F] [--seed N] [--reps R]\n"
+            "          [--filter TEXT] [--out FILE] [--dot-dir DIR]\n",
+            argv[0]);
+        return 2;
+    }
+
+    static const char* const PLAN[][2] = {
+        {"makeNodes", "rmat"},
+        {"createEdge", "rmat"},
+        {"createEdge", "chain"},
+        {"createEdge", "star"},
+        {"createEdge", "clique"},
+        {"addEdgesById", "rmat"},
+        {"getNodeAtLabel", "rmat"},
+        {"merge", "rmat"},
+        {"removeNode", "rmat"},
+        {"cloneNode", "rmat"},
+        {"bfs", "rmat"},
+        {"scc", "rmat"},
+        {"createDotFile", "rmat"}
+    };
+
+    std::vector<BenchResult> results;
+    for (std::size_t p = 0; p < sizeof(PLAN) / sizeof(PLAN[0]); p++)
+    {
+        std::string name = PLAN[p][0];
+        std::string workload = PLAN[p][1];
+        if (!config.filter.empty()
+            && (name + "/" + workload).find(config.filter) == std::string::npos)
+        {
+            continue;
+        }
+
+        // the workload is built after the reset, so it counts towards
+        // the peak like the graph does
+        resetPeakRss();
+        BenchResult result;
+        result.name = name;
+        result.workload = workload;
+        {
+            EdgeList edges = workloadEdges(config, workload);
+            std::vector<std::string> labels = makeLabels(nodeCount(edges), "v");
+            result.nodes = labels.size();
+            result.edges = edges.size();
+
+            if (name == "makeNodes")
+            {
+                benchMakeNodes(edges, labels, result);
+            }
+            else if (name == "createEdge")
+            {
+                benchCreateEdge(edges, labels, result);
+            }
+            else if (name == "addEdgesById")
+            {
+                benchAddEdgesById(config, edges, labels, result);
+            }
+            else if (name == "getNodeAtLabel")
+            {
+                benchGetNodeAtLabel(config, edges, labels, result);
+            }
+            else if (name == "merge")
+            {
+                benchMerge(config, edges, labels, result);
+            }
+            else if (name == "removeNode")
+            {
+                benchRemoveNode(config, edges, labels, result);
+            }
+            else if (name == "cloneNode")
+            {
+                benchCloneNode(config, edges, labels, result);
+            }
+            else if (name == "bfs" || name == "scc")
+            {
+                benchTraversal(config, name, edges, labels, result);
+            }
+            else
+            {
+                benchCreateDotFile(config, edges, labels, result);
+            }
+        }
+        result.peakRssKb = peakRssKb();
+        std::fprintf(stderr, "%s/%s: %llu ops in %.3fs\n", name.c_str(),
+                     workload.c_str(), (unsigned long long) result.ops,
+                     result.seconds);
+        results.push_back(result);
+    }
+
+    FILE* out = config.out.empty() ? stdout
+                                   : std::fopen(config.out.c_str(), "w");
+    if (out == NULL)
+    {
+        std::fprintf(stderr, "cannot write %s\n", config.out.c_str());
+        return 1;
+    }
+    std::fprintf(out, "{\n  \"scale\": %u, \"edgeFactor\": %u, "
+                 "\"seed\": %llu, \"reps\": %u,\n  \"results\": [\n",
+                 config.scale, config.edgeFactor,
+                 (unsigned long long) config.seed, config.reps);
+    for (std::size_t i = 0; i < results.size(); i++)
+    {
+        writeResult(out, results[i], i == 0);
+    }
+    std::fprintf(out, "\n  ]\n}\n");
+    if (out != stdout)
+    {
+        std::fclose(out);
+    }
+    return 0;
+}
@@ -0,0 +1,957 @@
+/*
+* graph_tests.cpp
+*
+* Checks Graph, its snapshot format and the algorithms and solvers built
+* on it against small brute-force references over seeded random graphs.
+* Prints every failed check and exits non-zero if there was one.
+*
+*   graph_tests [--filter TEXT]
+*/
+#include "Graph.h"
+#include "Andersen.h"
+#include "Steensgaard.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+static int failures = 0;
+
+static void
+check(bool ok, const char* what, const char* file, int line)
+{
+    if (!ok)
+    {
+        std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, what);
+        failures++;
+    }
+}
+
+#define CHECK(cond) check((cond), #cond, __FILE__, __LINE__)
+
+typedef std::mt19937 Random;
+typedef std::set<std::tuple<NodeId, NodeId, int> > EdgeSet;
+
+//===-----------------------------------------------------------------===//
+// Helpers
+
+static std::string
+name(unsigned i)
+{
+    return "v" + std::to_string(i);
+}
+
+// a graph with nodes v0 .. v(n-1), so node i has id i, and about m
+// random edges of either kind
+static void
+randomGraph(Graph& graph, unsigned n, unsigned m, Random& random)
+{
+    for (unsigned i = 0; i < n; i++)
+    {
+        graph.makeNode(name(i));
+    }
+    for (unsigned k = 0; k < m; k++)
+    {
+        graph.createEdgeById(random() % n, random() % n,
+                             random() % 2 ? EDGE_MAY : EDGE_MUST);
+    }
+}
+
+static EdgeSet
+edgesOf(Graph& graph)
+{
+    EdgeSet edges;
+    std::vector<Node*>* nodes = graph.getNodes();
+    for (std::size_t i = 0; i < nodes->size(); i++)
+    {
+        Node* node = (*nodes)[i];
+        if (node == NULL)
+        {
+            continue;
+        }
+        std::vector<Edge*>* out = node->getOutEdges();
+        for (std::size_t j = 0; j < out->size(); j++)
+        {
+            edges.insert(std::make_tuple(node->getId(),
+                                         (*out)[j]->getTarget()->getId(),
+                                         (int) (*out)[j]->getKind()));
+        }
+    }
+    return edges;
+}
+
+// the same edges by label, for graphs whose ids differ
+static std::set<std::tuple<std::string, std::string, int> >
+labeledEdgesOf(Graph& graph)
+{
+    std::set<std::tuple<std::string, std::string, int> > edges;
+    EdgeSet byId = edgesOf(graph);
+    for (EdgeSet::iterator it = byId.begin(); it != byId.end(); ++it)
+    {
+        edges.insert(std::make_tuple(
+            graph.getNodeById(std::get<0>(*it))->getLabelRef(),
+            graph.getNodeById(std::get<1>(*it))->getLabelRef(),
+            std::get<2>(*it)));
+    }
+    return edges;
+}
+
+// reach[v] lists every node reachable from v (v included), by DFS over
+// the Node lists
+static std::vector<std::vector<char> >
+reachMatrix(Graph& graph)
+{
+    NodeId n = graph.numNodeIds();
+    std::vector<std::vector<char> > reach(n, std::vector<char>(n, 0));
+    for (NodeId v = 0; v < n; v++)
+    {
+        if (graph.getNodeById(v) == NULL)
+        {
+            continue;
+        }
+        std::vector<NodeId> stack(1, v);
+        reach[v][v] = 1;
+        while (!stack.empty())
+        {
+            Node* node = graph.getNodeById(stack.back());
+            stack.pop_back();
+            std::vector<Edge*>* out = node->getOutEdges();
+            for (std::size_t j = 0; j < out->size(); j++)
+            {
+                NodeId w = (*out)[j]->getTarget()->getId();
+                if (!reach[v][w])
+                {
+                    reach[v][w] = 1;
+                    stack.push_back(w);
+                }
+            }
+        }
+    }
+    return reach;
+}
+
+static std::string
+readFile(const std::string& path)
+{
+    std::ifstream in(path.c_str(), std::ios::binary);
+    std::stringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+}
+
+static void
+writeFile(const std::string& path, const std::string& contents)
+{
+    std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+    out << contents;
+}
+
+//===-----------------------------------------------------------------===//
+// Labels and ids
+
+static void
+testTakeLabels()
+{
+    {
+        // a merge into a node that gave its labels away goes to that node
+        Graph graph;
+        Node* a = graph.makeNode("a");
+        Node* b = graph.makeNode("b");
+        Node* c = graph.makeNode("c");
+        graph.takeLabels(a, b);
+        CHECK(graph.getIdAtLabel("b") == a->getId());
+        CHECK(graph.resolve(b->getId()) == b->getId());
+        graph.merge(b, c);
+        CHECK(graph.getIdAtLabel("a") == a->getId());
+        CHECK(graph.getIdAtLabel("b") == a->getId());
+        CHECK(graph.getIdAtLabel("c") == b->getId());
+    }
+    {
+        // removing the taker leaves the giver live and resolvable
+        Graph graph;
+        Node* p = graph.makeNode("p");
+        Node* q = graph.makeNode("q");
+        NodeId qId = q->getId();
+        graph.takeLabels(p, q);
+        graph.removeNode(p);
+        CHECK(graph.resolve(qId) == qId);
+        CHECK(graph.getIdAtLabel("q") == INVALID_NODE);
+        CHECK(graph.getIdAtLabel("p") == INVALID_NODE);
+    }
+    {
+        // labels merged into the giver earlier move along
+        Graph graph;
+        Node* a = graph.makeNode("a");
+        Node* b = graph.makeNode("b");
+        graph.merge(b, graph.makeNode("c"));
+        graph.takeLabels(a, b);
+        CHECK(graph.getIdAtLabel("c") == a->getId());
+        graph.compact();
+        CHECK(graph.getIdAtLabel("c") == a->getId());
+        CHECK(graph.resolve(b->getId()) == b->getId());
+    }
+}
+
+// every live id resolves to itself after any mix of operations, and
+// every label resolves to a live node or to nothing
+static void
+testResolveInvariant()
+{
+    Random random(11);
+    for (int trial = 0; trial < 20; trial++)
+    {
+        Graph graph;
+        randomGraph(graph, 40, 80, random);
+        for (int step = 0; step < 200; step++)
+        {
+            Node* a = graph.getNodeAtLabel(name(random() % 40));
+            Node* b = graph.getNodeAtLabel(name(random() % 40));
+            if (a == NULL || b == NULL || a == b)
+            {
+                continue;
+            }
+            switch (random() % 4)
+            {
+                case 0:
+                    graph.takeLabels(a, b);
+                    break;
+                case 1:
+                    graph.merge(a, b);
+                    break;
+                case 2:
+                    if (random() % 4 == 0)
+                    {
+                        graph.removeNode(a);
+                    }
+                    break;
+                default:
+                    graph.createEdge(a, b);
+                    break;
+            }
+        }
+        for (NodeId v = 0; v < graph.numNodeIds(); v++)
+        {
+            if (graph.getNodeById(v) != NULL)
+            {
+                CHECK(graph.resolve(v) == v);
+            }
+        }
+        for (unsigned i = 0; i < 40; i++)
+        {
+            NodeId id = graph.getIdAtLabel(name(i));
+            CHECK(id == INVALID_NODE || graph.getNodeById(id) != NULL);
+        }
+    }
+}
+
+static void
+testEmptyLabel()
+{
+    Graph graph;
+    Node* empty = graph.makeNode("");
+    CHECK(empty != NULL);
+    CHECK(graph.getNodeAtLabel("") == empty);
+    CHECK(graph.makeNodes("", "x"));
+    CHECK(graph.getNodeAtLabel("")->getOutEdges()->size() == 1);
+
+    const char* path = "/tmp/graph_tests_empty.bin";
+    CHECK(graph.save(path));
+    Graph loaded;
+    CHECK(loaded.load(path));
+    CHECK(loaded.getIdAtLabel("") != INVALID_NODE);
+    std::remove(path);
+}
+
+// both id-based builders resolve merged-away ids the same way
+static void
+testEdgesById()
+{
+    for (int bulk = 0; bulk < 2; bulk++)
+    {
+        Graph graph;
+        NodeId x = graph.internLabel("x");
+        NodeId y = graph.internLabel("y");
+        NodeId z = graph.internLabel("z");
+        graph.merge(graph.getNodeById(x), graph.getNodeById(y));
+        if (bulk)
+        {
+            std::vector<std::pair<NodeId, NodeId> > edges;
+            edges.push_back(std::make_pair(y, z));
+            graph.addEdgesById(edges);
+        }
+        else
+        {
+            CHECK(graph.createEdgeById(y, z));
+        }
+        CHECK(graph.getNodeById(x)->alreadyHasEdge(graph.getNodeById(z)));
+        CHECK(!graph.createEdgeById(1000, z));
+    }
+
+    // per-pair kinds, with a pair listed both ways giving a may-edge
+    Graph graph;
+    for (unsigned i = 0; i < 4; i++)
+    {
+        graph.makeNode(name(i));
+    }
+    std::vector<std::pair<NodeId, NodeId> > edges;
+    std::vector<EdgeKind> kinds;
+    edges.push_back(std::make_pair(0, 1));
+    kinds.push_back(EDGE_MUST);
+    edges.push_back(std::make_pair(1, 2));
+    kinds.push_back(EDGE_MUST);
+    edges.push_back(std::make_pair(1, 2));
+    kinds.push_back(EDGE_MAY);
+    edges.push_back(std::make_pair(2, 3));
+    kinds.push_back(EDGE_MAY);
+    graph.addEdgesById(edges, kinds);
+    CHECK(graph.getNodeById(0)->findEdge(graph.getNodeById(1))->getKind()
+          == EDGE_MUST);
+    CHECK(graph.getNodeById(1)->findEdge(graph.getNodeById(2))->getKind()
+          == EDGE_MAY);
+    CHECK(graph.getNodeById(2)->findEdge(graph.getNodeById(3))->getKind()
+          == EDGE_MAY);
+}
+
+//===-----------------------------------------------------------------===//
+// Algorithms
+
+static void
+testReachability()
+{
+    Random random(3);
+    for (int trial = 0; trial < 30; trial++)
+    {
+        Graph graph;
+        unsigned n = 30 + random() % 50;
+        randomGraph(graph, n, n + random() % (2 * n), random);
+        std::vector<std::vector<char> > reach = reachMatrix(graph);
+        for (unsigned threads = 1; threads <= 2; threads++)
+        {
+            NodeId root = random() % n;
+            std::vector<uint64_t> visited;
+            graph.reachable(std::vector<NodeId>(1, root), visited, threads);
+            for (NodeId v = 0; v < n; v++)
+            {
+                bool seen = (visited[v / 64] >> (v % 64)) & 1;
+                CHECK(seen == (bool) reach[root][v]);
+            }
+        }
+        for (int query = 0; query < 50; query++)
+        {
+            NodeId a = random() % n;
+            NodeId b = random() % n;
+            CHECK(graph.reaches(a, b) == (bool) reach[a][b]);
+        }
+    }
+}
+
+static void
+testSCCs()
+{
+    Random random(5);
+    for (int trial = 0; trial < 30; trial++)
+    {
+        Graph graph;
+        unsigned n = 20 + random() % 40;
+        randomGraph(graph, n, n + random() % n, random);
+        std::vector<std::vector<char> > reach = reachMatrix(graph);
+        for (unsigned threads = 1; threads <= 2; threads++)
+        {
+            std::vector<NodeId> component;
+            graph.findSCCs(component, threads);
+            for (NodeId a = 0; a < n; a++)
+            {
+                for (NodeId b = 0; b < n; b++)
+                {
+                    bool together = reach[a][b] && reach[b][a];
+                    CHECK((component[a] == component[b]) == together);
+                }
+            }
+        }
+    }
+}
+
+// merges of nodes on no common path keep the maintained order valid;
+// any other merge drops it
+static void
+testTopologicalMerge()
+{
+    Random random(7);
+    for (int trial = 0; trial < 40; trial++)
+    {
+        Graph graph;
+        unsigned n = 20 + random() % 20;
+        for (unsigned i = 0; i < n; i++)
+        {
+            graph.makeNode(name(i));
+        }
+        for (unsigned k = 0; k < 2 * n; k++)
+        {
+            NodeId a = random() % n;
+            NodeId b = random() % n;
+            if (a < b)
+            {
+                graph.createEdgeById(a, b);
+            }
+        }
+        CHECK(graph.maintainTopologicalOrder());
+        while (graph.hasTopologicalOrder() && graph.numLiveNodes() > 2)
+        {
+            Node* a = graph.getNodeById(random() % n);
+            Node* b = graph.getNodeById(random() % n);
+            if (a == NULL || b == NULL || a == b)
+            {
+                continue;
+            }
+            std::vector<std::vector<char> > reach = reachMatrix(graph);
+            bool connected = reach[a->getId()][b->getId()]
+                || reach[b->getId()][a->getId()];
+            graph.merge(a, b);
+            CHECK(graph.hasTopologicalOrder() == !connected);
+            if (!graph.hasTopologicalOrder())
+            {
+                break;
+            }
+            std::vector<NodeId> order = graph.topologicalOrder();
+            CHECK(order.size() == graph.numLiveNodes());
+            std::vector<NodeId> position(graph.numNodeIds(), INVALID_NODE);
+            for (std::size_t i = 0; i < order.size(); i++)
+            {
+                position[order[i]] = (NodeId) i;
+            }
+            EdgeSet edges = edgesOf(graph);
+            for (EdgeSet::iterator it = edges.begin(); it != edges.end(); ++it)
+            {
+                CHECK(position[std::get<0>(*it)] < position[std::get<1>(*it)]);
+            }
+        }
+    }
+}
+
+//===-----------------------------------------------------------------===//
+// Snapshots and the change log
+
+static void
+testSnapshotRoundTrip()
+{
+    Random random(9);
+    const char* path = "/tmp/graph_tests_snapshot.bin";
+    for (int trial = 0; trial < 10; trial++)
+    {
+        Graph graph;
+        randomGraph(graph, 60, 150, random);
+        for (int k = 0; k < 5; k++)
+        {
+            Node* a = graph.getNodeAtLabel(name(random() % 60));
+            Node* b = graph.getNodeAtLabel(name(random() % 60));
+            if (a != NULL && b != NULL && a != b)
+            {
+                graph.merge(a, b);
+            }
+        }
+        CHECK(graph.save(path));
+        Graph loaded;
+        CHECK(loaded.load(path));
+        CHECK(loaded.numLiveNodes() == graph.numLiveNodes());
+        CHECK(labeledEdgesOf(loaded) == labeledEdgesOf(graph));
+        for (unsigned i = 0; i < 60; i++)
+        {
+            // merged-away labels still lead to the node holding them
+            Node* original = graph.getNodeAtLabel(name(i));
+            Node* copy = loaded.getNodeAtLabel(name(i));
+            CHECK(copy != NULL && original != NULL
+                  && copy->getLabelRef() == original->getLabelRef());
+        }
+    }
+
+    // saving over a mapped snapshot leaves the mapping intact
+    Graph graph;
+    randomGraph(graph, 30, 60, random);
+    CHECK(graph.save(path));
+    CSRGraph* mapped = CSRGraph::load(path);
+    CHECK(mapped != NULL);
+    graph.makeNodes("extra", name(0));
+    CHECK(graph.save(path));
+    if (mapped != NULL)
+    {
+        CHECK(mapped->numNodes() == 30);
+        std::size_t edges = 0;
+        for (NodeId v = 0; v < mapped->numNodes(); v++)
+        {
+            edges += mapped->outNeighbors(v).size();
+            CHECK(mapped->label(v) == name(v));
+        }
+        CHECK(edges == mapped->numEdges());
+        delete mapped;
+    }
+    std::remove(path);
+}
+
+// offsets of the header fields used below, as laid out by
+// CSRGraph::save: 8 bytes of magic, two 32-bit words, then 64-bit fields
+enum HeaderField {
+    NUM_NODES = 16, NUM_EDGES = 24, NUM_LABELS = 32, POOL_BYTES = 40,
+    NUM_BUCKETS = 48, OUT_OFFSETS_AT = 56, OUT_TARGETS_AT = 64,
+    OUT_KINDS_AT = 88, LABEL_OFFSETS_AT = 104, LABEL_NODES_AT = 112,
+    BUCKETS_AT = 128
+};
+
+static uint64_t
+field(const std::string& file, std::size_t at)
+{
+    uint64_t value;
+    std::memcpy(&value, file.data() + at, sizeof(value));
+    return value;
+}
+
+template <class T>
+static void
+poke(std::string& file, std::size_t at, T value)
+{
+    std::memcpy(&file[at], &value, sizeof(value));
+}
+
+static bool
+loads(const std::string& path, const std::string& contents)
+{
+    writeFile(path, contents);
+    CSRGraph* csr = CSRGraph::load(path);
+    delete csr;
+    return csr != NULL;
+}
+
+static void
+testCorruptSnapshots()
+{
+    Random random(13);
+    const char* path = "/tmp/graph_tests_corrupt.bin";
+    Graph graph;
+    randomGraph(graph, 40, 100, random);
+    CHECK(graph.save(path));
+    const std::string good = readFile(path);
+    CHECK(loads(path, good));
+
+    uint64_t n = field(good, NUM_NODES);
+    uint64_t m = field(good, NUM_EDGES);
+    uint64_t labels = field(good, NUM_LABELS);
+    std::string bad;
+
+    bad = good;
+    poke<NodeId>(bad, field(good, OUT_TARGETS_AT) + 4 * (m / 2), (NodeId) n);
+    CHECK(!loads(path, bad));
+
+    bad = good;
+    poke<uint64_t>(bad, field(good, OUT_OFFSETS_AT) + 8 * n, m + 1);
+    CHECK(!loads(path, bad));
+
+    bad = good;
+    poke<uint64_t>(bad, field(good, OUT_OFFSETS_AT) + 8 * (n / 2), m);
+    poke<uint64_t>(bad, field(good, OUT_OFFSETS_AT) + 8 * (n / 2 + 1), 0);
+    CHECK(!loads(path, bad));
+
+    bad = good;
+    poke<uint8_t>(bad, field(good, OUT_KINDS_AT), 7);
+    CHECK(!loads(path, bad));
+
+    bad = good;
+    poke<uint64_t>(bad, field(good, LABEL_OFFSETS_AT) + 8 * labels,
+                   field(good, POOL_BYTES) + 1);
+    CHECK(!loads(path, bad));
+
+    bad = good;
+    poke<NodeId>(bad, field(good, LABEL_NODES_AT), (NodeId) n);
+    CHECK(!loads(path, bad));
+
+    bad = good;
+    for (uint64_t b = 0; b < field(good, NUM_BUCKETS); b++)
+    {
+        poke<uint32_t>(bad, field(good, BUCKETS_AT) + 4 * b, 1);
+    }
+    CHECK(!loads(path, bad));
+
+    for (std::size_t length = 0; length < good.size(); length += 13)
+    {
+        CHECK(!loads(path, good.substr(0, length)));
+    }
+
+    // whatever a flipped byte lets through is safe to walk
+    for (std::size_t at = 0; at < good.size(); at += 5)
+    {
+        bad = good;
+        bad[at] ^= 0x5a;
+        writeFile(path, bad);
+        CSRGraph* csr = CSRGraph::load(path);
+        if (csr == NULL)
+        {
+            continue;
+        }
+        for (NodeId v = 0; v < csr->numNodes(); v++)
+        {
+            CSRGraph::NeighborRange targets = csr->outNeighbors(v);
+            for (std::size_t j = 0; j < targets.size(); j++)
+            {
+                CHECK(targets[j] < csr->numNodes());
+            }
+            csr->idOfLabel(csr->label(v));
+        }
+        delete csr;
+        Graph loaded;
+        loaded.load(path);
+    }
+    std::remove(path);
+}
+
+static void
+testChangeLogReplay()
+{
+    Random random(17);
+    const char* path = "/tmp/graph_tests_log.bin";
+    for (int trial = 0; trial < 10; trial++)
+    {
+        Graph graph;
+        randomGraph(graph, 50, 100, random);
+        graph.compact();
+        Graph copy(graph);
+        CHECK(graph.save(path));
+        unsigned long start = graph.getVersion();
+        graph.recordChanges(true);
+        for (int step = 0; step < 300; step++)
+        {
+            Node* a = graph.getNodeAtLabel(name(random() % 80));
+            Node* b = graph.getNodeAtLabel(name(random() % 80));
+            switch (random() % 7)
+            {
+                case 0:
+                case 1:
+                    graph.makeNodes(name(random() % 80), name(random() % 80),
+                                    random() % 2 ? EDGE_MAY : EDGE_MUST);
+                    break;
+                case 2:
+                    if (a != NULL && b != NULL)
+                    {
+                        graph.removeEdge(a, b);
+                    }
+                    break;
+                case 3:
+                    if (a != NULL && b != NULL)
+                    {
+                        graph.setEdgeKind(a, b, EDGE_MUST);
+                    }
+                    break;
+                case 4:
+                    if (a != NULL && b != NULL && random() % 3 == 0)
+                    {
+                        graph.merge(a, b);
+                    }
+                    break;
+                case 5:
+                    if (a != NULL && random() % 4 == 0)
+                    {
+                        graph.removeNode(a);
+                    }
+                    break;
+                default:
+                    if (a != NULL && b != NULL && a != b)
+                    {
+                        graph.takeLabels(a, b);
+                    }
+                    break;
+            }
+            if (step == 150)
+            {
+                graph.reorder(Graph::REORDER_RCM);
+            }
+        }
+        const ChangeLog* log = graph.changes();
+        CHECK(log->since(start) == 0);
+        CHECK(log->since(graph.getVersion()) == log->size());
+
+        CHECK(copy.replay(*log));
+        CHECK(edgesOf(copy) == edgesOf(graph));
+        Graph loaded;
+        CHECK(loaded.load(path));
+        CHECK(loaded.replay(*log));
+        CHECK(edgesOf(loaded) == edgesOf(graph));
+        for (unsigned i = 0; i < 80; i++)
+        {
+            CHECK(copy.getIdAtLabel(name(i)) == graph.getIdAtLabel(name(i)));
+            CHECK(loaded.getIdAtLabel(name(i)) == graph.getIdAtLabel(name(i)));
+        }
+    }
+    std::remove(path);
+}
+
+//===-----------------------------------------------------------------===//
+// Points-to solvers
+
+struct PointsToConstraint {
+    int kind;       // AndersenSolver / SteensgaardSolver ConstraintKind
+    NodeId dst;
+    NodeId src;
+};
+
+static std::vector<PointsToConstraint>
+randomConstraints(unsigned vars, unsigned count, Random& random)
+{
+    std::vector<PointsToConstraint> constraints;
+    for (unsigned i = 0; i < count; i++)
+    {
+        PointsToConstraint c;
+        c.kind = random() % 4;
+        c.dst = random() % vars;
+        c.src = random() % vars;
+        constraints.push_back(c);
+    }
+    return constraints;
+}
+
+static void
+testAndersen()
+{
+    Random random(19);
+    for (int trial = 0; trial < 30; trial++)
+    {
+        unsigned vars = 10 + random() % 30;
+        std::vector<PointsToConstraint> constraints =
+            randomConstraints(vars, vars * 3, random);
+
+        // naive fixpoint over the four rules
+        std::vector<std::set<NodeId> > pts(vars);
+        for (bool changed = true; changed; )
+        {
+            changed = false;
+            for (std::size_t i = 0; i < constraints.size(); i++)
+            {
+                const PointsToConstraint& c = constraints[i];
+                std::vector<std::pair<NodeId, NodeId> > flows;
+                switch (c.kind)
+                {
+                    case AndersenSolver::ADDRESS_OF:
+                        changed |= pts[c.dst].insert(c.src).second;
+                        break;
+                    case AndersenSolver::COPY:
+                        flows.push_back(std::make_pair(c.src, c.dst));
+                        break;
+                    case AndersenSolver::LOAD:
+                        for (NodeId o : pts[c.src])
+                        {
+                            flows.push_back(std::make_pair(o, c.dst));
+                        }
+                        break;
+                    default:
+                        for (NodeId o : pts[c.dst])
+                        {
+                            flows.push_back(std::make_pair(c.src, o));
+                        }
+                        break;
+                }
+                for (std::size_t f = 0; f < flows.size(); f++)
+                {
+                    std::set<NodeId> from = pts[flows[f].first];
+                    for (NodeId o : from)
+                    {
+                        changed |= pts[flows[f].second].insert(o).second;
+                    }
+                }
+            }
+        }
+
+        Graph graph;
+        for (unsigned v = 0; v < vars; v++)
+        {
+            graph.makeNode(name(v));
+        }
+        AndersenSolver solver(graph);
+        for (std::size_t i = 0; i < constraints.size(); i++)
+        {
+            solver.addConstraint(
+                (AndersenSolver::ConstraintKind) constraints[i].kind,
+                name(constraints[i].dst), name(constraints[i].src));
+        }
+        solver.solve();
+        for (unsigned v = 0; v < vars; v++)
+        {
+            std::vector<NodeId> expected(pts[v].begin(), pts[v].end());
+            CHECK(solver.pointsTo(name(v)) == expected);
+        }
+    }
+}
+
+// naive unification: every class has at most one pointee class
+struct NaiveUnification {
+    std::vector<NodeId> parent;
+    std::vector<NodeId> pointee;
+
+    NodeId make() {
+        parent.push_back((NodeId) parent.size());
+        pointee.push_back(INVALID_NODE);
+        return parent.back();
+    }
+
+    NodeId find(NodeId x) {
+        while (parent[x] != x)
+        {
+            x = parent[x];
+        }
+        return x;
+    }
+
+    NodeId deref(NodeId x) {
+        x = find(x);
+        if (pointee[x] == INVALID_NODE)
+        {
+            NodeId target = make();
+            pointee[x] = target;
+        }
+        return find(pointee[x]);
+    }
+
+    void join(NodeId a, NodeId b) {
+        a = find(a);
+        b = find(b);
+        if (a == b)
+        {
+            return;
+        }
+        NodeId pa = pointee[a];
+        NodeId pb = pointee[b];
+        parent[b] = a;
+        pointee[a] = pa != INVALID_NODE ? pa : pb;
+        if (pa != INVALID_NODE && pb != INVALID_NODE)
+        {
+            join(pa, pb);
+        }
+    }
+};
+
+static void
+testSteensgaard()
+{
+    Random random(23);
+    for (int trial = 0; trial < 30; trial++)
+    {
+        unsigned vars = 10 + random() % 30;
+        std::vector<PointsToConstraint> constraints =
+            randomConstraints(vars, vars * 2, random);
+
+        NaiveUnification naive;
+        for (unsigned v = 0; v < vars; v++)
+        {
+            naive.make();
+        }
+        for (std::size_t i = 0; i < constraints.size(); i++)
+        {
+            NodeId d = constraints[i].dst;
+            NodeId s = constraints[i].src;
+            switch (constraints[i].kind)
+            {
+                case SteensgaardSolver::ADDRESS_OF:
+                    naive.join(naive.deref(d), s);
+                    break;
+                case SteensgaardSolver::COPY:
+                    naive.join(naive.deref(d), naive.deref(s));
+                    break;
+                case SteensgaardSolver::LOAD:
+                    naive.join(naive.deref(d), naive.deref(naive.deref(s)));
+                    break;
+                default:
+                    naive.join(naive.deref(naive.deref(d)), naive.deref(s));
+                    break;
+            }
+        }
+
+        Graph graph;
+        for (unsigned v = 0; v < vars; v++)
+        {
+            graph.makeNode(name(v));
+        }
+        SteensgaardSolver solver(graph);
+        for (std::size_t i = 0; i < constraints.size(); i++)
+        {
+            solver.addConstraint(
+                (SteensgaardSolver::ConstraintKind) constraints[i].kind,
+                name(constraints[i].dst), name(constraints[i].src));
+        }
+        solver.solve();
+
+        // variables share a node exactly when they share a class
+        for (NodeId a = 0; a < vars; a++)
+        {
+            for (NodeId b = 0; b < vars; b++)
+            {
+                CHECK((naive.find(a) == naive.find(b))
+                      == (graph.resolve(a) == graph.resolve(b)));
+            }
+        }
+        // and a variable points to the node of any variable in its
+        // pointee class
+        for (NodeId v = 0; v < vars; v++)
+        {
+            NodeId target = naive.pointee[naive.find(v)];
+            if (target == INVALID_NODE)
+            {
+                continue;
+            }
+            for (NodeId w = 0; w < vars; w++)
+            {
+                if (naive.find(w) == naive.find(target))
+                {
+                    CHECK(solver.pointsTo(v) == graph.resolve(w));
+                    break;
+                }
+            }
+        }
+    }
+}
+
+//===-----------------------------------------------------------------===//
+
+struct TestCase {
+    const char* name;
+    void (*run)();
+};
+
+static const TestCase TESTS[] = {
+    {"takeLabels", testTakeLabels},
+    {"resolveInvariant", testResolveInvariant},
+    {"emptyLabel", testEmptyLabel},
+    {"edgesById", testEdgesById},
+    {"reachability", testReachability},
+    {"sccs", testSCCs},
+    {"topologicalMerge", testTopologicalMerge},
+    {"snapshotRoundTrip", testSnapshotRoundTrip},
+    {"corruptSnapshots", testCorruptSnapshots},
+    {"changeLogReplay", testChangeLogReplay},
+    {"andersen", testAndersen},
+    {"steensgaard", testSteensgaard},
+};
+
+int
+main(int argc, char** argv)
+{
+    std::string filter;
+    if (argc == 3 && std::strcmp(argv[1], "--filter") == 0)
+    {
+        filter = argv[2];
+    }
+    for (std::size_t i = 0; i < sizeof(TESTS) / sizeof(TESTS[0]); i++)
+    {
+        if (std::string(TESTS[i].name).find(filter) == std::string::npos)
+        {
+            continue;
+        }
+        int before = failures;
+        TESTS[i].run();
+        std::fprintf(stderr, "%-20s %s\n", TESTS[i].name,
+                     failures == before ? "ok" : "FAILED");
+    }
+    return failures == 0 ? 0 : 1;
+}